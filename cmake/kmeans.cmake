@@ -74,7 +74,8 @@ function(kmeans_add_common TARGET OUTPUT_DIRECTORY)
       /nologo # Silence MSVC compiler version output.
       /wd4068 # Allow unknown pragmas.
       /wd4221 # Results in false positives.
-      /arch:AVX
+      # No /arch: like -march below, only the kernels of the higher instruction
+      # set levels get /arch:AVX2 and /arch:AVX512 (see CMakeLists.txt).
       /fp:fast
       $<$<BOOL:${KMEANS_WARNINGS_AS_ERRORS}>:/WX> # -Werror
       $<$<BOOL:${KMEANS_CXX_HAVE_PERMISSIVE}>:/permissive->
@@ -101,10 +102,12 @@ function(kmeans_add_common TARGET OUTPUT_DIRECTORY)
       $<$<BOOL:${KMEANS_WARNINGS_AS_ERRORS}>:-pedantic-errors>
     )
 
-    if(CMAKE_CXX_COMPILER_ID STREQUAL "Intel")
-      target_compile_options(${TARGET} PRIVATE -xCORE-AVX-I)
-    else()
-      target_compile_options(${TARGET} PRIVATE -march=core-avx-i -ffast-math)
+    # No -march: the distance kernels are compiled for several instruction set
+    # levels and picked at runtime (see src/kmeans/simd.hpp) so a single build
+    # runs on every x86-64 machine. The Intel compiler uses fast floating
+    # point math by default.
+    if(NOT CMAKE_CXX_COMPILER_ID STREQUAL "Intel")
+      target_compile_options(${TARGET} PRIVATE -ffast-math)
     endif()
   endif()
 
@@ -1,52 +1,585 @@
 #include <kmeans/CSVReader.hpp>
 
 #include <algorithm>
-#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace kmeans {
 
-CSVReader::CSVReader(std::istream &stream, char delimiter, char comment)
-    : stream_(stream), delimiter_(delimiter), comment_(comment)
-{}
+// Bytes per chunk. Large enough to amortize the bookkeeping per chunk and
+// small enough to balance the chunks over the threads.
+static const size_t chunk_size = 1 << 20;
+
+// Doubles that are exactly representable powers of ten.
+static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                1e18, 1e19, 1e20, 1e21, 1e22};
+
+static bool space(char character)
+{
+  return character == ' ' || character == '\t' || character == '\r';
+}
+
+static bool digit(char character)
+{
+  return character >= '0' && character <= '9';
+}
+
+// End of the line that starts at begin (its newline or the end of the file).
+static const char *line_end(const char *begin, const char *end)
+{
+  const void *newline = std::memchr(begin, '\n',
+                                    static_cast<size_t>(end - begin));
+  return newline != nullptr ? static_cast<const char *>(newline) : end;
+}
+
+// Start of the line after the line that starts at begin.
+static const char *next_line(const char *begin, const char *end)
+{
+  const char *newline = line_end(begin, end);
+  return newline < end ? newline + 1 : end;
+}
+
+// Start of the first line that starts at or after position.
+static const char *line_start(const char *data,
+                              const char *position,
+                              const char *end)
+{
+  return position == data || position[-1] == '\n' ? position
+                                                   : next_line(position, end);
+}
+
+// Splits the lines in [part_begin, part_end) in chunks of about chunk_size
+// bytes. Every chunk starts on the first line that starts in its range of
+// bytes and ends where the next one starts.
+static std::vector<const char *> split(const char *data,
+                                       const char *part_begin,
+                                       const char *part_end,
+                                       const char *end)
+{
+  size_t part_size = static_cast<size_t>(part_end - part_begin);
+  uint32_t chunks = static_cast<uint32_t>((part_size + chunk_size - 1) /
+                                          chunk_size);
+  auto chunk_begins = std::vector<const char *>(chunks + 1, part_end);
+  chunk_begins[0] = part_begin;
+
+  for (uint32_t i = 1; i < chunks; i++) {
+    const char *begin = std::max(part_begin + i * chunk_size,
+                                 chunk_begins[i - 1]);
+    chunk_begins[i] = std::min(line_start(data, begin, end), part_end);
+  }
+
+  return chunk_begins;
+}
+
+static bool skipped(const char *begin, const char *end, char comment)
+{
+  if (end > begin && end[-1] == '\r') {
+    end--;
+  }
+
+  return begin == end || *begin == comment;
+}
 
-bool CSVReader::read(std::vector<double> &to) // NOLINT
+// Points without nonzero values are stored as empty lines in sparse files, so
+// only comments are skipped.
+static bool commented(const char *begin, const char *end, char comment)
 {
-  std::string line;
+  return begin < end && *begin == comment;
+}
 
-  do {
-    getline(stream_, line);
-  } while (!stream_.eof() && (line.empty() || line[0] == comment_));
+// Hands the numbers the fast path doesn't handle (more than 19 digits, large
+// exponents, hexadecimal, infinity, ...) to strtod with a copy of the number
+// on the stack since the mapped file isn't null terminated.
+static bool fallback(const char *begin, const char *end, double *value)
+{
+  char buffer[128];
+  size_t length = static_cast<size_t>(end - begin);
 
-  if (stream_.eof()) {
+  if (length >= sizeof(buffer)) {
     return false;
   }
 
-  size_t count = static_cast<size_t>(
-      std::count(line.begin(), line.end(), delimiter_) + 1);
+  std::memcpy(buffer, begin, length);
+  buffer[length] = '\0';
 
-  to.resize(count);
-  size_t endPos = 0, pos = 0;
+  char *last = nullptr;
+  *value = std::strtod(buffer, &last);
 
-  try {
-    for (size_t i = 0; i < count; ++i) {
-      endPos = line.find(delimiter_, pos);
-      if (std::string::npos != endPos) {
-        to[i] = std::stod(line.substr(pos, endPos - pos));
-        pos = endPos + 1;
-      } else {
-        to[i] = std::stod(line.substr(pos));
-      }
+  return last == buffer + length;
+}
+
+// Parses the unsigned integer in [begin, end) that is less than limit.
+static bool parse(const char *begin,
+                  const char *end,
+                  uint64_t limit,
+                  uint64_t *value)
+{
+  *value = 0;
+
+  for (const char *position = begin; position < end; position++) {
+    if (!digit(*position)) {
+      return false;
+    }
+
+    *value = *value * 10 + static_cast<uint64_t>(*position - '0');
+
+    if (*value >= limit) {
+      return false;
     }
-  } catch (const std::invalid_argument &) {
-    std::cerr << "Can't convert '" << line.substr(pos, endPos - pos) << "'"
-              << std::endl;
-    return false;
-  } catch (const std::out_of_range &) {
-    std::cerr << "Argument is out of range for a double" << std::endl;
-    return false;
   }
 
+  return begin < end;
+}
+
+// Parses the number in [begin, end) without allocating. Like std::stod, the
+// whitespace around the number is ignored. Returns false if it isn't a number.
+static bool parse(const char *begin, const char *end, double *value)
+{
+  while (begin < end && space(*begin)) {
+    begin++;
+  }
+
+  while (end > begin && space(end[-1])) {
+    end--;
+  }
+
+  const char *position = begin;
+  bool negative = position < end && *position == '-';
+
+  if (position < end && (*position == '-' || *position == '+')) {
+    position++;
+  }
+
+  uint64_t mantissa = 0;
+  int32_t digits = 0;
+  int32_t exponent = 0;
+  bool number = false;
+
+  for (; position < end && digit(*position); position++) {
+    number = true;
+    digits += mantissa != 0 || *position != '0' ? 1 : 0;
+    mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+  }
+
+  if (position < end && *position == '.') {
+    position++;
+
+    for (; position < end && digit(*position); position++) {
+      number = true;
+      digits += mantissa != 0 || *position != '0' ? 1 : 0;
+      mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+      exponent--;
+    }
+  }
+
+  if (number && position < end && (*position == 'e' || *position == 'E')) {
+    position++;
+
+    bool negative_exponent = position < end && *position == '-';
+
+    if (position < end && (*position == '-' || *position == '+')) {
+      position++;
+    }
+
+    int32_t written = 0;
+    bool written_digits = false;
+
+    for (; position < end && digit(*position); position++) {
+      written_digits = true;
+      written = std::min(written * 10 + (*position - '0'), 100000);
+    }
+
+    if (!written_digits) {
+      return false;
+    }
+
+    exponent += negative_exponent ? -written : written;
+  }
+
+  // A mantissa of at most 2^53 and a power of ten of at most 10^22 are both
+  // exact doubles so a single multiplication or division rounds correctly.
+  if (!number || position != end || digits > 19 ||
+      mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22) {
+    return fallback(begin, end, value);
+  }
+
+  double result = static_cast<double>(mantissa);
+  result = exponent < 0 ? result / powers[-exponent]
+                        : result * powers[exponent];
+
+  *value = negative ? -result : result;
   return true;
 }
 
+CSVReader::CSVReader(const std::string &path, char delimiter, char comment)
+    : path_(path), delimiter_(delimiter), comment_(comment)
+{
+#ifdef _WIN32
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+  if (!file) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  size_ = static_cast<size_t>(file.tellg());
+  char *buffer = new char[std::max<size_t>(size_, 1)];
+  file.seekg(0);
+  file.read(buffer, static_cast<std::streamsize>(size_));
+  data_ = buffer;
+#else
+  int file = open(path.c_str(), O_RDONLY);
+
+  if (file < 0) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  struct stat status = {};
+  fstat(file, &status);
+  size_ = static_cast<size_t>(status.st_size);
+
+  if (size_ > 0) {
+    void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+
+    if (map == MAP_FAILED) {
+      close(file);
+      throw std::runtime_error("Can't map '" + path + "'");
+    }
+
+    madvise(map, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(map);
+  }
+
+  close(file);
+#endif
+}
+
+CSVReader::~CSVReader()
+{
+#ifdef _WIN32
+  delete[] data_;
+#else
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+}
+
+real *CSVReader::read(uint32_t *amount, uint32_t *dimension)
+{
+  return read(0, 1, amount, dimension);
+}
+
+real *CSVReader::read(int part, int parts, uint32_t *amount,
+                      uint32_t *dimension)
+{
+  *dimension = first_dimension();
+
+  const char *end = data_ + size_;
+  uint64_t size = size_;
+  uint64_t uparts = static_cast<uint64_t>(parts);
+  const char *part_begin = line_start(
+      data_, data_ + size * static_cast<uint64_t>(part) / uparts, end);
+  const char *part_end = line_start(
+      data_, data_ + size * static_cast<uint64_t>(part + 1) / uparts, end);
+
+  return read_lines(part_begin, part_end, *dimension, amount);
+}
+
+real *CSVReader::next(size_t bytes, uint32_t *amount, uint32_t *dimension)
+{
+  *dimension = first_dimension();
+
+  const char *end = data_ + size_;
+
+  if (position_ == nullptr) {
+    position_ = data_;
+  }
+
+  if (position_ == end) {
+    *amount = 0;
+    return nullptr;
+  }
+
+  const char *begin = position_;
+  position_ = line_start(
+      data_, begin + std::min(bytes, static_cast<size_t>(end - begin)), end);
+
+  real *points = read_lines(begin, position_, *dimension, amount);
+
+#ifndef _WIN32
+  // Drop the pages that were parsed so the mapping doesn't keep the whole file
+  // resident. Pages of the current line are kept.
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t parsed = static_cast<size_t>(position_ - data_) / page * page;
+
+  if (parsed > 0) {
+    madvise(const_cast<char *>(data_), parsed, MADV_DONTNEED);
+  }
+#endif
+
+  return points;
+}
+
+csr::matrix CSVReader::read_sparse(uint32_t *amount, uint32_t *dimension)
+{
+  csr::matrix points = read_sparse(0, 1, amount, dimension);
+
+  if (*amount == 0) {
+    csr::release(points);
+    throw std::runtime_error("No points in '" + path_ + "'");
+  }
+
+  return points;
+}
+
+csr::matrix CSVReader::read_sparse(int part,
+                                   int parts,
+                                   uint32_t *amount,
+                                   uint32_t *dimension)
+{
+  const char *end = data_ + size_;
+  uint64_t size = size_;
+  uint64_t uparts = static_cast<uint64_t>(parts);
+  const char *part_begin = line_start(
+      data_, data_ + size * static_cast<uint64_t>(part) / uparts, end);
+  const char *part_end = line_start(
+      data_, data_ + size * static_cast<uint64_t>(part + 1) / uparts, end);
+
+  auto chunk_begins = split(data_, part_begin, part_end, end);
+  auto chunks = static_cast<uint32_t>(chunk_begins.size() - 1);
+  auto chunk_rows = std::vector<uint32_t>(chunks + 1);
+  auto chunk_nonzeros = std::vector<uint64_t>(chunks + 1);
+
+  // Every pair has a single colon so the colons count the nonzero values of a
+  // line as long as it is valid.
+#pragma omp parallel for schedule(dynamic)
+  for (uint32_t i = 0; i < chunks; i++) {
+    uint32_t rows = 0;
+    uint64_t nonzeros = 0;
+
+    for (const char *line = chunk_begins[i]; line < chunk_begins[i + 1];) {
+      const char *next = line_end(line, end);
+
+      if (!commented(line, next, comment_)) {
+        rows++;
+        nonzeros += static_cast<uint64_t>(std::count(line, next, ':'));
+      }
+
+      line = next < end ? next + 1 : end;
+    }
+
+    chunk_rows[i + 1] = rows;
+    chunk_nonzeros[i + 1] = nonzeros;
+  }
+
+  for (uint32_t i = 0; i < chunks; i++) {
+    chunk_rows[i + 1] += chunk_rows[i];
+    chunk_nonzeros[i + 1] += chunk_nonzeros[i];
+  }
+
+  *amount = chunk_rows[chunks];
+
+  csr::matrix points = csr::allocate(*amount, chunk_nonzeros[chunks]);
+  auto chunk_dimensions = std::vector<uint32_t>(chunks);
+  auto errors = std::vector<std::string>(chunks);
+
+#pragma omp parallel for schedule(dynamic)
+  for (uint32_t i = 0; i < chunks; i++) {
+    uint32_t row = chunk_rows[i];
+    uint64_t nonzero = chunk_nonzeros[i];
+
+    for (const char *line = chunk_begins[i]; line < chunk_begins[i + 1];) {
+      const char *next = line_end(line, end);
+
+      if (commented(line, next, comment_)) {
+        line = next < end ? next + 1 : end;
+        continue;
+      }
+
+      for (const char *field = line; field < next;) {
+        while (field < next && space(*field)) {
+          field++;
+        }
+
+        const char *field_end = field;
+
+        while (field_end < next && !space(*field_end)) {
+          field_end++;
+        }
+
+        if (field == field_end) {
+          break;
+        }
+
+        const char *colon = std::find(field, field_end, ':');
+        uint64_t index = 0;
+        double value = 0;
+
+        if (colon == field_end ||
+            !parse(field, colon, UINT32_MAX, &index) ||
+            !parse(colon + 1, field_end, &value)) {
+          errors[i] = "Can't convert '" + std::string(field, field_end) + "'";
+          break;
+        }
+
+        points.indices[nonzero] = static_cast<uint32_t>(index);
+        points.values[nonzero] = static_cast<real>(value);
+        nonzero++;
+
+        chunk_dimensions[i] = std::max(chunk_dimensions[i],
+                                       static_cast<uint32_t>(index + 1));
+        field = field_end;
+      }
+
+      if (!errors[i].empty()) {
+        break;
+      }
+
+      points.offsets[++row] = nonzero;
+      line = next < end ? next + 1 : end;
+    }
+  }
+
+  for (const std::string &error : errors) {
+    if (!error.empty()) {
+      csr::release(points);
+      throw std::runtime_error(error);
+    }
+  }
+
+  *dimension = 0;
+
+  for (uint32_t chunk_dimension : chunk_dimensions) {
+    *dimension = std::max(*dimension, chunk_dimension);
+  }
+
+  csr::norms(points, *amount);
+
+  return points;
+}
+
+uint32_t CSVReader::first_dimension()
+{
+  if (dimension_ != 0) {
+    return dimension_;
+  }
+
+  const char *end = data_ + size_;
+  const char *first = data_;
+
+  while (first < end && skipped(first, line_end(first, end), comment_)) {
+    first = next_line(first, end);
+  }
+
+  if (first == end) {
+    throw std::runtime_error("No points in '" + path_ + "'");
+  }
+
+  dimension_ = static_cast<uint32_t>(
+      std::count(first, line_end(first, end), delimiter_) + 1);
+
+  return dimension_;
+}
+
+real *CSVReader::read_lines(const char *part_begin,
+                            const char *part_end,
+                            uint32_t dimension,
+                            uint32_t *amount)
+{
+  const char *end = data_ + size_;
+  auto chunk_begins = split(data_, part_begin, part_end, end);
+  auto chunks = static_cast<uint32_t>(chunk_begins.size() - 1);
+  auto chunk_rows = std::vector<uint32_t>(chunks + 1);
+
+#pragma omp parallel for schedule(dynamic)
+  for (uint32_t i = 0; i < chunks; i++) {
+    uint32_t rows = 0;
+
+    for (const char *line = chunk_begins[i]; line < chunk_begins[i + 1];) {
+      const char *next = line_end(line, end);
+
+      if (!skipped(line, next, comment_)) {
+        rows++;
+      }
+
+      line = next < end ? next + 1 : end;
+    }
+
+    chunk_rows[i + 1] = rows;
+  }
+
+  for (uint32_t i = 0; i < chunks; i++) {
+    chunk_rows[i + 1] += chunk_rows[i];
+  }
+
+  *amount = chunk_rows[chunks];
+
+  real *points = new real[static_cast<size_t>(*amount) * dimension];
+  auto errors = std::vector<std::string>(chunks);
+
+#pragma omp parallel for schedule(dynamic)
+  for (uint32_t i = 0; i < chunks; i++) {
+    real *point = points + static_cast<size_t>(chunk_rows[i]) * dimension;
+
+    for (const char *line = chunk_begins[i]; line < chunk_begins[i + 1];) {
+      const char *next = line_end(line, end);
+
+      if (skipped(line, next, comment_)) {
+        line = next < end ? next + 1 : end;
+        continue;
+      }
+
+      const char *field = line;
+
+      for (uint32_t j = 0; j < dimension; j++) {
+        const char *field_end = std::find(field, next, delimiter_);
+        double value = 0;
+
+        if ((field_end == next) != (j + 1 == dimension)) {
+          errors[i] = "Expected " + std::to_string(dimension) +
+                      " values in '" + std::string(line, next) + "'";
+          break;
+        }
+
+        if (!parse(field, field_end, &value)) {
+          errors[i] = "Can't convert '" + std::string(field, field_end) + "'";
+          break;
+        }
+
+        point[j] = static_cast<real>(value);
+        field = field_end + 1;
+      }
+
+      if (!errors[i].empty()) {
+        break;
+      }
+
+      point += dimension;
+      line = next < end ? next + 1 : end;
+    }
+  }
+
+  for (const std::string &error : errors) {
+    if (!error.empty()) {
+      delete[] points;
+      throw std::runtime_error(error);
+    }
+  }
+
+  return points;
+}
+
 }
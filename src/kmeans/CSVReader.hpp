@@ -1,22 +1,77 @@
 #pragma once
 
-#include <vector>
-#include <iosfwd>
+#include <kmeans/csr.hpp>
+#include <kmeans/real.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace kmeans {
 
+// Reads a file with a point per line and the values of each point separated by
+// the delimiter. Empty lines and lines starting with the comment character are
+// skipped. The file is mapped into memory and split in chunks that end on a
+// newline, which are parsed in parallel straight into a single array.
 class CSVReader {
 public:
-  explicit CSVReader(std::istream &stream,
+  explicit CSVReader(const std::string &path,
                      char delimiter = ',',
                      char comment = '#');
 
-  bool read(std::vector<double> &to); // NOLINT
+  ~CSVReader();
+
+  CSVReader(const CSVReader &) = delete;
+  CSVReader &operator=(const CSVReader &) = delete;
+
+  // Returns the points as a new amount * dimension array. Every point needs to
+  // have the dimension of the first point.
+  real *read(uint32_t *amount, uint32_t *dimension);
+
+  // Like read() but only returns the points on the lines that start in the
+  // part-th of parts equally sized byte ranges of the file, which can be
+  // empty. The dimension is still that of the first point in the file.
+  real *read(int part, int parts, uint32_t *amount, uint32_t *dimension);
+
+  // Returns the points on the lines that start in the next bytes bytes after
+  // the points returned by the previous call, or nullptr at the end of the
+  // file. Parsed pages are dropped from memory so streaming through a file
+  // only keeps about bytes of it resident.
+  real *next(size_t bytes, uint32_t *amount, uint32_t *dimension);
+
+  // Returns sparse points stored as the nonzero coordinates of a point per line
+  // in index:value pairs separated by spaces or tabs, with zero-based indices
+  // (e.g. "3:0.5 17:2"). The dimension is one more than the largest index.
+  // Empty lines are points without nonzero values.
+  csr::matrix read_sparse(uint32_t *amount, uint32_t *dimension);
+
+  // Like read_sparse() but only returns the points on the lines that start in
+  // the part-th of parts equally sized byte ranges of the file, which can be
+  // empty. The dimension is that of the points in the part.
+  csr::matrix read_sparse(int part,
+                          int parts,
+                          uint32_t *amount,
+                          uint32_t *dimension);
 
 private:
-  std::istream &stream_;
+  // Dimension of the first point in the file.
+  uint32_t first_dimension();
+
+  // Parses the lines in [part_begin, part_end) in parallel chunks into a new
+  // array.
+  real *read_lines(const char *part_begin,
+                   const char *part_end,
+                   uint32_t dimension,
+                   uint32_t *amount);
+
+  const std::string path_;
   const char delimiter_;
   const char comment_;
+
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  uint32_t dimension_ = 0;
+  const char *position_ = nullptr;
 };
 
 }
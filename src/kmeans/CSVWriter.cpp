@@ -4,8 +4,11 @@
 
 namespace kmeans {
 
-CSVWriter::CSVWriter(std::ostream &stream, char delimiter)
-    : stream_(stream), delimiter_(delimiter)
+// Bytes formatted before they're written to the stream by the integer writer.
+static const size_t integer_buffer_size = 1 << 20;
+
+CSVWriter::CSVWriter(std::ostream &stream, char delimiter, int precision)
+    : stream_(stream), delimiter_(delimiter), precision_(precision)
 {}
 
 void CSVWriter::write(const std::vector<double> &row)
@@ -22,10 +25,11 @@ void CSVWriter::write(const std::vector<double> &row)
     size_t difference = static_cast<size_t>(total - len);
 
     if (i == 0) {
-      len += snprintf(buffer + len, difference, "%.10g", row[i]); // NOLINT
-    } else {
-      len += snprintf(buffer + len, difference, "%c%.10g", delimiter_,
+      len += snprintf(buffer + len, difference, "%.*g", precision_,
                       row[i]); // NOLINT
+    } else {
+      len += snprintf(buffer + len, difference, "%c%.*g", delimiter_,
+                      precision_, row[i]); // NOLINT
     }
   }
 
@@ -35,4 +39,51 @@ void CSVWriter::write(const std::vector<double> &row)
   stream_.write(buffer, len);                      // NOLINT
 }
 
+void CSVWriter::write(const uint16_t *row, size_t amount)
+{
+  append(row, amount);
+  end();
+}
+
+void CSVWriter::append(const uint16_t *values, size_t amount)
+{
+  auto buffer = std::vector<char>(integer_buffer_size);
+  size_t len = 0;
+
+  for (size_t i = 0; i < amount; i++) {
+    // Room for the delimiter and the 5 digits of a uint16_t.
+    if (buffer.size() - len < 6) {
+      stream_.write(buffer.data(), static_cast<std::streamsize>(len));
+      len = 0;
+    }
+
+    if (row_started_) {
+      buffer[len++] = delimiter_;
+    }
+
+    row_started_ = true;
+
+    char digits[5];
+    size_t count = 0;
+    uint32_t value = values[i];
+
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value > 0);
+
+    while (count > 0) {
+      buffer[len++] = digits[--count];
+    }
+  }
+
+  stream_.write(buffer.data(), static_cast<std::streamsize>(len));
+}
+
+void CSVWriter::end()
+{
+  stream_.put('\n');
+  row_started_ = false;
+}
+
 }
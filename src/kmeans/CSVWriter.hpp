@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <vector>
 
@@ -7,13 +9,26 @@ namespace kmeans {
 
 class CSVWriter {
 public:
-  explicit CSVWriter(std::ostream &stream, char delimiter = ',');
+  explicit CSVWriter(std::ostream &stream,
+                     char delimiter = ',',
+                     int precision = 10);
 
   void write(const std::vector<double> &row);
 
+  // Writes amount integers as a single row without going through a vector of
+  // doubles and snprintf.
+  void write(const uint16_t *row, size_t amount);
+
+  // Like write() but the row can be written in parts: append() adds values to
+  // the current row and end() ends it.
+  void append(const uint16_t *values, size_t amount);
+  void end();
+
 private:
   std::ostream &stream_;
   char delimiter_;
+  int precision_;
+  bool row_started_ = false;
   static const std::streamsize total = 8192;
 };
 
@@ -0,0 +1,492 @@
+#include <kmeans/accumulation.hpp>
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace kmeans {
+namespace accumulation {
+
+// Values of the sums reduced at a time, so the tree goes over blocks that stay
+// in the cache instead of going over every part per value.
+static const uint32_t block = 1024;
+
+static uint32_t max_threads()
+{
+#ifdef _OPENMP
+  return static_cast<uint32_t>(std::max(omp_get_max_threads(), 1));
+#else
+  return 1;
+#endif
+}
+
+static uint32_t thread_number()
+{
+#ifdef _OPENMP
+  return static_cast<uint32_t>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+static uint32_t team_size()
+{
+#ifdef _OPENMP
+  return static_cast<uint32_t>(omp_get_num_threads());
+#else
+  return 1;
+#endif
+}
+
+// Makes sure array holds at least size values. The values aren't kept.
+template <typename T>
+static T *reserve(T *&array, size_t &capacity, size_t size)
+{
+  if (capacity < size) {
+    delete[] array;
+    array = new T[size];
+    capacity = size;
+  }
+
+  return array;
+}
+
+void release(const buffer &buffer)
+{
+  delete[] buffer.sums;
+  delete[] buffer.counts;
+  delete[] buffer.order;
+}
+
+// Adds the values first up to last of every part(i) to part(0), pairing parts
+// that are 1, 2, 4, ... apart.
+template <typename Part>
+static void tree(Part part, uint32_t parts, uint32_t first, uint32_t last)
+{
+  for (uint32_t stride = 1; stride < parts; stride *= 2) {
+    for (uint32_t i = 0; i + stride < parts; i += 2 * stride) {
+      double *sum = part(i);
+      double *other_sum = part(i + stride);
+
+      for (uint32_t j = first; j < last; j++) {
+        sum[j] += other_sum[j];
+      }
+    }
+  }
+}
+
+void reduce(double **sums, uint32_t parts, uint32_t first, uint32_t last)
+{
+#pragma omp parallel
+  team::reduce(sums, parts, first, last);
+}
+
+// Makes room for a part per thread of parts threads in buffer.
+static void reserve(buffer *buffer,
+                    size_t parts,
+                    uint16_t clusters,
+                    uint32_t dimension)
+{
+  reserve(buffer->sums, buffer->sums_size, parts * clusters * dimension);
+  reserve(buffer->counts, buffer->counts_size, parts * clusters);
+}
+
+template <typename Add>
+static void serial(Add add,
+                   uint16_t *point_clusters,
+                   uint32_t amount,
+                   double *centroid_sums,
+                   uint32_t *cluster_sizes,
+                   uint32_t dimension)
+{
+  for (uint32_t i = 0; i < amount; i++) {
+    uint16_t cluster = point_clusters[i];
+    cluster_sizes[cluster]++;
+    add(centroid_sums + cluster * dimension, i);
+  }
+}
+
+// Called by every thread of the team, like sharded().
+template <typename Add>
+static void privatized(buffer *buffer,
+                       Add add,
+                       uint16_t *point_clusters,
+                       uint32_t amount,
+                       double *centroid_sums,
+                       uint32_t *cluster_sizes,
+                       uint16_t clusters,
+                       uint32_t dimension)
+{
+  uint32_t thread = thread_number();
+  uint32_t parts = team_size();
+  uint32_t size = clusters * dimension;
+
+#pragma omp single
+  reserve(buffer, parts, clusters, dimension);
+
+  double *sums = buffer->sums;
+  uint32_t *counts = buffer->counts;
+
+  // The first thread adds to centroid_sums itself.
+  auto part = [centroid_sums, sums, size](uint32_t i) {
+    return i == 0 ? centroid_sums : sums + static_cast<size_t>(i - 1) * size;
+  };
+
+  double *thread_sums = part(thread);
+  uint32_t *thread_counts = counts + thread * clusters;
+
+  // Every thread clears its own sums so they're first touched by it.
+  if (thread > 0) {
+    std::fill_n(thread_sums, size, 0);
+  }
+
+  std::fill_n(thread_counts, clusters, 0);
+
+#pragma omp for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    uint16_t cluster = point_clusters[i];
+    thread_counts[cluster]++;
+    add(thread_sums + cluster * dimension, i);
+  }
+
+  uint32_t blocks = (size + block - 1) / block;
+
+#pragma omp for schedule(static) nowait
+  for (uint32_t i = 0; i < blocks; i++) {
+    tree(part, parts, i * block, std::min((i + 1) * block, size));
+  }
+
+#pragma omp for schedule(static)
+  for (uint16_t i = 0; i < clusters; i++) {
+    for (uint32_t j = 0; j < parts; j++) {
+      cluster_sizes[i] += counts[j * clusters + i];
+    }
+  }
+}
+
+// Called by every thread of the team. Returns after every thread is done.
+template <typename Add>
+static void sharded(buffer *buffer,
+                    Add add,
+                    uint16_t *point_clusters,
+                    uint32_t amount,
+                    double *centroid_sums,
+                    uint32_t *cluster_sizes,
+                    uint16_t clusters,
+                    uint32_t dimension)
+{
+  uint32_t thread = thread_number();
+  uint32_t parts = team_size();
+
+  // Counts of every thread followed by the first sorted point of every
+  // cluster and the first cluster of every thread.
+#pragma omp single
+  {
+    reserve(buffer->counts, buffer->counts_size,
+            static_cast<size_t>(parts) * clusters + clusters + parts + 2);
+    reserve(buffer->order, buffer->order_size, amount);
+  }
+
+  uint32_t *counts = buffer->counts;
+  uint32_t *cluster_firsts = counts + parts * clusters;
+  uint32_t *thread_firsts = cluster_firsts + clusters + 1;
+  uint32_t *order = buffer->order;
+  uint32_t *thread_counts = counts + thread * clusters;
+
+  std::fill_n(thread_counts, clusters, 0);
+
+#pragma omp for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    thread_counts[point_clusters[i]]++;
+  }
+
+  // Turns the counts into the position of the first point of every thread in
+  // every cluster and divides the clusters over the threads.
+#pragma omp single
+  {
+    uint32_t position = 0;
+    uint32_t part = 1;
+    thread_firsts[0] = 0;
+
+    for (uint16_t i = 0; i < clusters; i++) {
+      cluster_firsts[i] = position;
+
+      // A thread starts at the first cluster after its share of points.
+      while (part < parts &&
+             position >= static_cast<uint64_t>(amount) * part / parts) {
+        thread_firsts[part++] = i;
+      }
+
+      for (uint32_t j = 0; j < parts; j++) {
+        uint32_t count = counts[j * clusters + i];
+        counts[j * clusters + i] = position;
+        position += count;
+      }
+
+      cluster_sizes[i] += position - cluster_firsts[i];
+    }
+
+    cluster_firsts[clusters] = position;
+
+    while (part <= parts) {
+      thread_firsts[part++] = clusters;
+    }
+  }
+
+  // The same static schedule gives every thread the same points again.
+#pragma omp for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    order[thread_counts[point_clusters[i]]++] = i;
+  }
+
+  for (uint32_t i = thread_firsts[thread]; i < thread_firsts[thread + 1];
+       i++) {
+    double *centroid_sum = centroid_sums + i * dimension;
+
+    for (uint32_t j = cluster_firsts[i]; j < cluster_firsts[i + 1]; j++) {
+      add(centroid_sum, order[j]);
+    }
+  }
+
+#pragma omp barrier
+}
+
+// Called by every thread of the team.
+template <typename Add>
+static void shared(buffer *buffer,
+                   Add add,
+                   uint16_t *point_clusters,
+                   uint32_t amount,
+                   double *centroid_sums,
+                   uint32_t *cluster_sizes,
+                   uint16_t clusters,
+                   uint32_t dimension)
+{
+  if (team_size() == 1) {
+    serial(add, point_clusters, amount, centroid_sums, cluster_sizes,
+           dimension);
+  } else if (clusters * dimension * sizeof(double) <= privatized_size) {
+    privatized(buffer, add, point_clusters, amount, centroid_sums,
+               cluster_sizes, clusters, dimension);
+  } else {
+    sharded(buffer, add, point_clusters, amount, centroid_sums, cluster_sizes,
+            clusters, dimension);
+  }
+}
+
+template <typename Add>
+static void accumulate(buffer *buffer,
+                       Add add,
+                       uint16_t *point_clusters,
+                       uint32_t amount,
+                       double *centroid_sums,
+                       uint32_t *cluster_sizes,
+                       uint16_t clusters,
+                       uint32_t dimension)
+{
+  uint32_t max_threads = accumulation::max_threads();
+
+  if (max_threads == 1) {
+    serial(add, point_clusters, amount, centroid_sums, cluster_sizes,
+           dimension);
+    return;
+  }
+
+#pragma omp parallel num_threads(max_threads)
+  shared(buffer, add, point_clusters, amount, centroid_sums, cluster_sizes,
+         clusters, dimension);
+}
+
+void accumulate(buffer *buffer,
+                real *points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension)
+{
+  auto add = [points, dimension](double *sum, uint32_t i) {
+    kmeans::accumulate(sum, points + static_cast<size_t>(i) * dimension,
+                       dimension);
+  };
+
+  accumulate(buffer, add, point_clusters, amount, centroid_sums, cluster_sizes,
+             clusters, dimension);
+}
+
+void accumulate(buffer *buffer,
+                const csr::matrix &points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension)
+{
+  auto add = [&points](double *sum, uint32_t i) {
+    csr::accumulate(sum, points, i);
+  };
+
+  accumulate(buffer, add, point_clusters, amount, centroid_sums, cluster_sizes,
+             clusters, dimension);
+}
+
+namespace team {
+
+void accumulate(buffer *buffer,
+                real *points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension)
+{
+  auto add = [points, dimension](double *sum, uint32_t i) {
+    kmeans::accumulate(sum, points + static_cast<size_t>(i) * dimension,
+                       dimension);
+  };
+
+  shared(buffer, add, point_clusters, amount, centroid_sums, cluster_sizes,
+         clusters, dimension);
+}
+
+void accumulate(buffer *buffer,
+                const csr::matrix &points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension)
+{
+  auto add = [&points](double *sum, uint32_t i) {
+    csr::accumulate(sum, points, i);
+  };
+
+  shared(buffer, add, point_clusters, amount, centroid_sums, cluster_sizes,
+         clusters, dimension);
+}
+
+void reduce(double **sums, uint32_t parts, uint32_t first, uint32_t last)
+{
+  auto part = [sums](uint32_t i) { return sums[i]; };
+  uint32_t blocks = (last - first + block - 1) / block;
+
+#pragma omp for schedule(static)
+  for (uint32_t i = 0; i < blocks; i++) {
+    uint32_t block_first = first + i * block;
+    tree(part, parts, block_first, std::min(block_first + block, last));
+  }
+}
+
+void reserve(buffer *buffer, uint16_t clusters, uint32_t dimension)
+{
+#pragma omp single
+  accumulation::reserve(buffer, team_size(), clusters, dimension);
+}
+
+void average(double *centroid_sums,
+             uint32_t *cluster_sizes,
+             real *centroids,
+             uint16_t clusters,
+             uint32_t dimension)
+{
+#pragma omp for schedule(static)
+  for (uint16_t i = 0; i < clusters; i++) {
+    real *centroid = centroids + i * dimension;
+    double *centroid_sum = centroid_sums + i * dimension;
+
+    if (cluster_sizes[i] == 0) {
+      continue;
+    }
+
+    for (uint32_t j = 0; j < dimension; j++) {
+      centroid[j] = static_cast<real>(centroid_sum[j] / cluster_sizes[i]);
+    }
+  }
+}
+
+}
+
+bool fused(uint16_t clusters, uint32_t dimension)
+{
+  return clusters * dimension * sizeof(double) <= privatized_size;
+}
+
+bool incremental(uint32_t period, uint32_t iteration)
+{
+  return period > 0 && iteration % period != 0;
+}
+
+void reserve(buffer *buffer, uint16_t clusters, uint32_t dimension)
+{
+  reserve(buffer, accumulation::max_threads(), clusters, dimension);
+}
+
+part begin(buffer *buffer, uint16_t clusters, uint32_t dimension, bool moved)
+{
+  size_t thread = thread_number();
+
+  part part = {buffer->sums + thread * clusters * dimension,
+               buffer->counts + thread * clusters, moved};
+
+  // Every thread clears its own part so it's first touched by it.
+  std::fill_n(part.sums, clusters * dimension, 0);
+  std::fill_n(part.sizes, clusters, 0);
+
+  return part;
+}
+
+void end(buffer *buffer,
+         double *centroid_sums,
+         uint32_t *cluster_sizes,
+         uint16_t clusters,
+         uint32_t dimension)
+{
+  uint32_t parts = team_size();
+  uint32_t size = clusters * dimension;
+  uint32_t blocks = (size + block - 1) / block;
+
+  double *sums = buffer->sums;
+  uint32_t *counts = buffer->counts;
+
+  auto part = [sums, size](uint32_t i) {
+    return sums + static_cast<size_t>(i) * size;
+  };
+
+#pragma omp for schedule(static) nowait
+  for (uint32_t i = 0; i < blocks; i++) {
+    uint32_t first = i * block;
+    uint32_t last = std::min(first + block, size);
+
+    tree(part, parts, first, last);
+
+    for (uint32_t j = first; j < last; j++) {
+      centroid_sums[j] += sums[j];
+    }
+  }
+
+#pragma omp for schedule(static)
+  for (uint16_t i = 0; i < clusters; i++) {
+    for (uint32_t j = 0; j < parts; j++) {
+      cluster_sizes[i] += counts[j * clusters + i];
+    }
+  }
+}
+
+void average(double *centroid_sums,
+             uint32_t *cluster_sizes,
+             real *centroids,
+             uint16_t clusters,
+             uint32_t dimension)
+{
+#pragma omp parallel
+  team::average(centroid_sums, cluster_sizes, centroids, clusters, dimension);
+}
+
+}
+}
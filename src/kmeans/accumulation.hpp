@@ -0,0 +1,218 @@
+#pragma once
+
+#include <kmeans/csr.hpp>
+#include <kmeans/distance.hpp>
+#include <kmeans/real.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kmeans {
+namespace accumulation {
+
+// Sums the points of every cluster with every thread of a parallel region
+// opened in the calling thread (nested in the parallel implementations).
+// Depending on the size of the centroid sums one of two strategies is used:
+//
+// - privatized: every thread sums its share of the points in its own copy of
+//   the centroid sums, after which the copies are added together by a tree
+//   reduction that is parallel over the values of the sums.
+// - sharded: the points are sorted by cluster (a parallel counting sort of
+//   their indices) and every thread sums the points of its own range of
+//   clusters, balanced by the amount of points in the clusters. The sums are
+//   only stored once, which keeps large sums out of every other cache.
+
+// Largest centroid sums (in bytes) that are privatized.
+const size_t privatized_size = size_t(1) << 18;
+
+// Scratch space of accumulate(), grown on demand and kept between calls.
+// Every thread calling accumulate() at the same time needs its own buffer.
+struct buffer {
+  double *sums = nullptr;
+  size_t sums_size = 0;
+  uint32_t *counts = nullptr;
+  size_t counts_size = 0;
+  uint32_t *order = nullptr;
+  size_t order_size = 0;
+};
+
+void release(const buffer &buffer);
+
+// Adds amount points to the sum of the centroid of their cluster in
+// centroid_sums (clusters * dimension) and counts them in cluster_sizes
+// (clusters).
+void accumulate(buffer *buffer,
+                real *points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension);
+
+void accumulate(buffer *buffer,
+                const csr::matrix &points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension);
+
+// Adds the values first up to last of parts arrays of sums to sums[0] by a
+// tree reduction, parallel over the values. The other arrays are overwritten.
+void reduce(double **sums, uint32_t parts, uint32_t first, uint32_t last);
+
+// Accumulation fused into the assignment of the points: every thread of the
+// parallel loop that assigns the points adds each point to its own part of the
+// sums right after choosing its cluster, so an iteration only reads the points
+// once. Only used for sums that accumulate() privatizes, larger sums make the
+// assignment bound by the distance computations instead of by memory.
+//
+// reserve() is called before the parallel region, begin() by every thread in
+// it before the loop and end() by every thread after the loop.
+//
+// Incremental iterations (see incremental()) keep the sums of the previous
+// iteration and only move the points that changed cluster from the sum of
+// their previous cluster to the sum of their new one, so late iterations cost
+// in proportion to the points that moved. A part then holds the change of the
+// sums. The sizes stay unsigned: a cluster that loses points wraps around,
+// which adding the sizes together undoes.
+
+// Whether the sums of the given size are accumulated during the assignment.
+bool fused(uint16_t clusters, uint32_t dimension);
+
+// Whether the given iteration (counted from 0 per repetition) only moves the
+// points that changed cluster. Every period-th iteration sums every point
+// again, which bounds the rounding errors that build up in the sums. A period
+// of 0 always sums every point.
+bool incremental(uint32_t period, uint32_t iteration);
+
+// Sums of the points added by a single thread.
+struct part {
+  double *sums;
+  uint32_t *sizes;
+  bool moved;
+};
+
+inline void add(const part &part,
+                uint16_t previous_cluster,
+                uint16_t cluster,
+                real *point,
+                uint32_t dimension)
+{
+  if (!part.moved) {
+    part.sizes[cluster]++;
+    kmeans::accumulate(part.sums + cluster * dimension, point, dimension);
+    return;
+  }
+
+  if (previous_cluster == cluster) {
+    return;
+  }
+
+  double *previous_sum = part.sums + previous_cluster * dimension;
+  double *sum = part.sums + cluster * dimension;
+
+  part.sizes[previous_cluster]--;
+  part.sizes[cluster]++;
+
+  for (uint32_t j = 0; j < dimension; j++) {
+    previous_sum[j] -= point[j];
+    sum[j] += point[j];
+  }
+}
+
+inline void add(const part &part,
+                uint16_t previous_cluster,
+                uint16_t cluster,
+                const csr::matrix &points,
+                uint32_t i,
+                uint32_t dimension)
+{
+  if (!part.moved) {
+    part.sizes[cluster]++;
+    csr::accumulate(part.sums + cluster * dimension, points, i);
+    return;
+  }
+
+  if (previous_cluster == cluster) {
+    return;
+  }
+
+  double *previous_sum = part.sums + previous_cluster * dimension;
+  double *sum = part.sums + cluster * dimension;
+
+  part.sizes[previous_cluster]--;
+  part.sizes[cluster]++;
+
+  for (uint64_t j = points.offsets[i]; j < points.offsets[i + 1]; j++) {
+    previous_sum[points.indices[j]] -= points.values[j];
+    sum[points.indices[j]] += points.values[j];
+  }
+}
+
+// Makes room for a part per thread of a parallel region started by the
+// calling thread.
+void reserve(buffer *buffer, uint16_t clusters, uint32_t dimension);
+
+// Returns the cleared part of the calling thread, which only moves the points
+// that changed cluster when moved is set.
+part begin(buffer *buffer, uint16_t clusters, uint32_t dimension, bool moved);
+
+// Adds the parts of every thread to centroid_sums and cluster_sizes like
+// accumulate().
+void end(buffer *buffer,
+         double *centroid_sums,
+         uint32_t *cluster_sizes,
+         uint16_t clusters,
+         uint32_t dimension);
+
+// Stores the centroid of every cluster that isn't empty in centroids. An empty
+// cluster keeps its centroid instead of dividing by zero.
+void average(double *centroid_sums,
+             uint32_t *cluster_sizes,
+             real *centroids,
+             uint16_t clusters,
+             uint32_t dimension);
+
+// Versions of the functions above that are called by every thread of a
+// parallel region that is already open and share the work between its threads
+// instead of opening a parallel region of their own, so a team that stays open
+// for every iteration doesn't pay for starting one per step. They return once
+// every thread of the team is done.
+namespace team {
+
+void accumulate(buffer *buffer,
+                real *points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension);
+
+void accumulate(buffer *buffer,
+                const csr::matrix &points,
+                uint16_t *point_clusters,
+                uint32_t amount,
+                double *centroid_sums,
+                uint32_t *cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension);
+
+void reduce(double **sums, uint32_t parts, uint32_t first, uint32_t last);
+
+// Makes room for a part per thread of the team for begin().
+void reserve(buffer *buffer, uint16_t clusters, uint32_t dimension);
+
+void average(double *centroid_sums,
+             uint32_t *cluster_sizes,
+             real *centroids,
+             uint16_t clusters,
+             uint32_t dimension);
+
+}
+
+}
+}
@@ -18,6 +18,16 @@ const char *missing_argument::what() const noexcept
   return what.str().c_str();
 }
 
+invalid_argument::invalid_argument(const std::string &argument,
+                                   const std::string &value)
+    : message("Invalid value for argument " + argument + ": " + value)
+{}
+
+const char *invalid_argument::what() const noexcept
+{
+  return message.c_str();
+}
+
 static std::string
 parse_required_argument(const std::vector<std::string> &raw_args,
                         const std::string &argument)
@@ -31,14 +41,110 @@ parse_required_argument(const std::vector<std::string> &raw_args,
   throw missing_argument(argument);
 }
 
+static std::string
+parse_optional_argument(const std::vector<std::string> &raw_args,
+                        const std::string &argument,
+                        const std::string &fallback)
+{
+  auto position = std::find(raw_args.begin(), raw_args.end(), argument);
+
+  if (position != raw_args.end() && ++position != raw_args.end()) {
+    return *position;
+  }
+
+  return fallback;
+}
+
+static bool parse_flag(const std::vector<std::string> &raw_args,
+                       const std::string &argument)
+{
+  return std::find(raw_args.begin(), raw_args.end(), argument) !=
+         raw_args.end();
+}
+
+static assignment parse_assignment(const std::string &value)
+{
+  if (value == "lloyd") {
+    return assignment::lloyd;
+  }
+
+  if (value == "elkan") {
+    return assignment::elkan;
+  }
+
+  if (value == "hamerly") {
+    return assignment::hamerly;
+  }
+
+  if (value == "yinyang") {
+    return assignment::yinyang;
+  }
+
+  throw invalid_argument("--assignment", value);
+}
+
+static kernel parse_kernel(const std::string &value)
+{
+  if (value == "direct") {
+    return kernel::direct;
+  }
+
+  if (value == "gemm") {
+    return kernel::gemm;
+  }
+
+  throw invalid_argument("--kernel", value);
+}
+
+static seeding parse_seeding(const std::string &value)
+{
+  if (value == "random") {
+    return seeding::random;
+  }
+
+  if (value == "kmeans++") {
+    return seeding::kmeanspp;
+  }
+
+  if (value == "kmeans||") {
+    return seeding::scalable;
+  }
+
+  throw invalid_argument("--seeding", value);
+}
+
 args::args(uint16_t clusters,
            uint32_t repetitions,
            std::string input_csv,
-           std::string output_csv)
+           std::string output_csv,
+           kmeans::assignment assignment,
+           kmeans::kernel kernel,
+           kmeans::seeding seeding,
+           uint32_t batch_size,
+           uint32_t batch_iterations,
+           bool batch_refine,
+           uint32_t incremental,
+           bool binary_output,
+           std::string centroids_path,
+           std::string initial_centroids_path,
+           std::string out_of_core_directory,
+           bool sparse)
     : clusters(clusters),
       repetitions(repetitions),
       input_csv_path(std::move(input_csv)),
-      output_csv_path(std::move(output_csv))
+      output_csv_path(std::move(output_csv)),
+      assignment(assignment),
+      kernel(kernel),
+      seeding(seeding),
+      batch_size(batch_size),
+      batch_iterations(batch_iterations),
+      batch_refine(batch_refine),
+      incremental(incremental),
+      binary_output(binary_output),
+      centroids_path(std::move(centroids_path)),
+      initial_centroids_path(std::move(initial_centroids_path)),
+      out_of_core_directory(std::move(out_of_core_directory)),
+      sparse(sparse)
 {}
 
 args args::parse(int argc, char **argv)
@@ -57,7 +163,74 @@ args args::parse(int argc, char **argv)
   std::string input_csv = parse_required_argument(raw_args, "--input");
   std::string output_csv = parse_required_argument(raw_args, "--output");
 
-  return args(clusters, repetitions, input_csv, output_csv);
+  kmeans::assignment assignment = parse_assignment(
+      parse_optional_argument(raw_args, "--assignment", "lloyd"));
+  kmeans::kernel kernel = parse_kernel(
+      parse_optional_argument(raw_args, "--kernel", "direct"));
+  std::string seeding_name = parse_optional_argument(raw_args, "--seeding",
+                                                     "");
+  kmeans::seeding seeding = parse_seeding(seeding_name.empty() ? "random"
+                                                               : seeding_name);
+  std::string initial_centroids_path = parse_optional_argument(
+      raw_args, "--init-centroids", "");
+
+  // Loaded centroids take the place of the seeding algorithm.
+  if (!initial_centroids_path.empty()) {
+    if (!seeding_name.empty()) {
+      throw invalid_argument("--seeding",
+                             seeding_name +
+                                 " (can't be combined with --init-centroids)");
+    }
+
+    seeding = kmeans::seeding::given;
+  }
+
+  uint32_t batch_size = static_cast<uint32_t>(
+      std::stoull(parse_optional_argument(raw_args, "--batch-size", "0")));
+  uint32_t batch_iterations = static_cast<uint32_t>(std::stoull(
+      parse_optional_argument(raw_args, "--batch-iterations", "100")));
+  bool batch_refine = parse_flag(raw_args, "--batch-refine");
+  uint32_t incremental = static_cast<uint32_t>(
+      std::stoull(parse_optional_argument(raw_args, "--incremental", "0")));
+
+  std::string out_of_core_directory = parse_optional_argument(
+      raw_args, "--out-of-core", "");
+
+  bool sparse = parse_flag(raw_args, "--sparse");
+
+  bool binary_output = parse_flag(raw_args, "--binary-output");
+  std::string centroids_path = parse_optional_argument(raw_args, "--centroids",
+                                                       "");
+
+  // The assignment algorithms with bounds compute single distances so only
+  // Lloyd can make use of the gemm kernel.
+  if (kernel == kmeans::kernel::gemm &&
+      assignment != kmeans::assignment::lloyd) {
+    throw invalid_argument("--kernel", "gemm (requires --assignment lloyd)");
+  }
+
+  // The bounds of the other assignment algorithms take more memory than the
+  // points themselves for all but the smallest k.
+  if (!out_of_core_directory.empty() &&
+      assignment != kmeans::assignment::lloyd) {
+    throw invalid_argument("--out-of-core",
+                           out_of_core_directory +
+                               " (requires --assignment lloyd)");
+  }
+
+  // The sparse kernels cover Lloyd iterations seeded from single points.
+  if (sparse && (assignment != kmeans::assignment::lloyd ||
+                 kernel != kmeans::kernel::direct ||
+                 seeding == kmeans::seeding::scalable || batch_size > 0)) {
+    throw invalid_argument("--sparse",
+                           "requires --assignment lloyd, --kernel direct, "
+                           "no --batch-size and no --seeding kmeans||");
+  }
+
+  return args(clusters, repetitions, input_csv, output_csv, assignment, kernel,
+              seeding, batch_size, batch_iterations, batch_refine,
+              incremental, binary_output, centroids_path,
+              initial_centroids_path, out_of_core_directory, sparse);
 }
 
 }
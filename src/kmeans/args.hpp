@@ -1,5 +1,9 @@
 #pragma once
 
+#include <kmeans/assignment.hpp>
+#include <kmeans/kernel.hpp>
+#include <kmeans/seeding.hpp>
+
 #include <string>
 
 namespace kmeans {
@@ -14,11 +18,33 @@ private:
   std::string argument;
 };
 
+class invalid_argument : public std::exception {
+public:
+  invalid_argument(const std::string &argument, const std::string &value);
+
+  const char *what() const noexcept override;
+
+private:
+  std::string message;
+};
+
 struct args {
   const uint16_t clusters;
   const uint32_t repetitions;
   const std::string input_csv_path;
   const std::string output_csv_path;
+  const kmeans::assignment assignment;
+  const kmeans::kernel kernel;
+  const kmeans::seeding seeding;
+  const uint32_t batch_size;
+  const uint32_t batch_iterations;
+  const bool batch_refine;
+  const uint32_t incremental;
+  const bool binary_output;
+  const std::string centroids_path;
+  const std::string initial_centroids_path;
+  const std::string out_of_core_directory;
+  const bool sparse;
 
   static args parse(int argc, char *argv[]);
 
@@ -26,7 +52,19 @@ private:
   args(uint16_t clusters,
        uint32_t repetitions,
        std::string input_csv,
-       std::string output_csv);
+       std::string output_csv,
+       kmeans::assignment assignment,
+       kmeans::kernel kernel,
+       kmeans::seeding seeding,
+       uint32_t batch_size,
+       uint32_t batch_iterations,
+       bool batch_refine,
+       uint32_t incremental,
+       bool binary_output,
+       std::string centroids_path,
+       std::string initial_centroids_path,
+       std::string out_of_core_directory,
+       bool sparse);
 };
 
 }
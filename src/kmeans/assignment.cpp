@@ -0,0 +1,35 @@
+#include <kmeans/assignment.hpp>
+
+#include <kmeans/yinyang.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace kmeans {
+
+uint32_t bounds(assignment assignment, uint16_t clusters)
+{
+  switch (assignment) {
+    case assignment::elkan:
+      return clusters;
+    case assignment::hamerly:
+      return 1;
+    case assignment::yinyang:
+      return yinyang::groups(clusters);
+    case assignment::lloyd:
+      break;
+  }
+
+  return 0;
+}
+
+void reset(double *upper_bounds,
+           double *lower_bounds,
+           uint32_t amount,
+           uint32_t bounds)
+{
+  std::fill_n(upper_bounds, amount, std::numeric_limits<double>::max());
+  std::fill_n(lower_bounds, static_cast<size_t>(amount) * bounds, 0);
+}
+
+}
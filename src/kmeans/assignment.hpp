@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace kmeans {
+
+// The algorithm used to find the nearest centroid of each point. Lloyd
+// computes the distance to every centroid while the others keep bounds per
+// point to skip distance computations that can't change the nearest centroid.
+enum class assignment { lloyd, elkan, hamerly, yinyang };
+
+// Amount of lower bounds stored per point by the given assignment algorithm.
+uint32_t bounds(assignment assignment, uint16_t clusters);
+
+// Loosens the bounds of amount points as far as possible so the next
+// assignment computes the distance to every centroid it needs to.
+void reset(double *upper_bounds,
+           double *lower_bounds,
+           uint32_t amount,
+           uint32_t bounds);
+
+}
@@ -0,0 +1,322 @@
+#include <kmeans/binary.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kmeans {
+namespace binary {
+
+static const char magic[8] = {'K', 'M', 'E', 'A', 'N', 'S', 'P', 'T'};
+static const uint32_t version = 1;
+
+static_assert(sizeof(header) == 64, "The header is 64 bytes");
+
+// Points that are used in place and the mapping they are part of.
+struct mapping {
+  real *points;
+  void *address;
+  size_t length;
+};
+
+static std::vector<mapping> mappings;
+
+header describe(uint64_t amount, uint64_t dimension, binary::dtype dtype)
+{
+  header header = {};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.dtype = dtype;
+  header.amount = amount;
+  header.dimension = dimension;
+  header.offset = alignment;
+  header.stride = dimension;
+  header.alignment = alignment;
+
+  return header;
+}
+
+size_t size(binary::dtype dtype)
+{
+  return dtype == dtype::float32 ? sizeof(float) : sizeof(double);
+}
+
+// Whether the host stores integers and floating point values little endian
+// like point files do.
+static bool little_endian()
+{
+  uint32_t value = 1;
+  unsigned char first;
+  std::memcpy(&first, &value, sizeof(first));
+
+  return first == 1;
+}
+
+// Checks that header describes points that fit in a file of length bytes.
+static void validate(const header &header,
+                     size_t length,
+                     const std::string &path)
+{
+  if (!little_endian()) {
+    throw std::runtime_error("Point files need a little endian host");
+  }
+
+  if (header.version != version ||
+      (header.dtype != dtype::float64 && header.dtype != dtype::float32)) {
+    throw std::runtime_error("Unsupported point file '" + path + "'");
+  }
+
+  uint64_t value_size = size(header.dtype);
+  uint64_t limit = std::numeric_limits<uint32_t>::max();
+
+  // The implementations count points and values with 32 bits and index all
+  // values of the points with size_t.
+  if (header.amount == 0 || header.dimension == 0 || header.amount > limit ||
+      header.dimension > limit ||
+      header.amount > std::numeric_limits<size_t>::max() / sizeof(real) /
+                          header.dimension ||
+      header.stride < header.dimension ||
+      header.offset < sizeof(binary::header) || header.offset > length ||
+      header.offset % value_size != 0) {
+    throw std::runtime_error("Invalid point file '" + path + "'");
+  }
+
+  // The last point ends (amount - 1) * stride + dimension values after the
+  // offset. Every term is compared against the values left in the file before
+  // it's computed so nothing overflows.
+  uint64_t values = (length - header.offset) / value_size;
+
+  if (header.dimension > values ||
+      (header.amount > 1 && header.stride > (values - header.dimension) /
+                                                (header.amount - 1))) {
+    throw std::runtime_error("Invalid point file '" + path + "'");
+  }
+}
+
+void convert(const char *bytes,
+             const header &header,
+             uint32_t amount,
+             real *points)
+{
+  size_t dimension = header.dimension;
+
+#pragma omp parallel for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    const char *row =
+        bytes + static_cast<size_t>(i * header.stride * size(header.dtype));
+    real *point = points + static_cast<size_t>(i) * dimension;
+
+    for (size_t j = 0; j < dimension; j++) {
+      if (header.dtype == dtype::float32) {
+        float value;
+        std::memcpy(&value, row + j * sizeof(float), sizeof(float));
+        point[j] = static_cast<real>(value);
+      } else {
+        double value;
+        std::memcpy(&value, row + j * sizeof(double), sizeof(double));
+        point[j] = static_cast<real>(value);
+      }
+    }
+  }
+}
+
+bool native(const header &header)
+{
+  return header.dtype == real_dtype && header.stride == header.dimension;
+}
+
+bool detect(const std::string &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  char bytes[sizeof(magic)] = {};
+
+  file.read(bytes, sizeof(bytes));
+
+  return file && std::memcmp(bytes, magic, sizeof(magic)) == 0;
+}
+
+header inspect(const std::string &path)
+{
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+  if (!file) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  size_t length = static_cast<size_t>(file.tellg());
+  header header = {};
+
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+  if (!file) {
+    throw std::runtime_error("Invalid point file '" + path + "'");
+  }
+
+  validate(header, length, path);
+
+  return header;
+}
+
+real *read(const std::string &path, uint32_t *amount, uint32_t *dimension)
+{
+#ifdef _WIN32
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+  if (!file) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  auto bytes = std::vector<char>(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+  header header = {};
+  std::memcpy(&header, bytes.data(),
+              std::min(sizeof(header), bytes.size()));
+  validate(header, bytes.size(), path);
+
+  *amount = static_cast<uint32_t>(header.amount);
+  *dimension = static_cast<uint32_t>(header.dimension);
+
+  real *points = new real[static_cast<size_t>(*amount) * *dimension];
+  convert(bytes.data() + header.offset, header, *amount, points);
+
+  return points;
+#else
+  int file = open(path.c_str(), O_RDONLY);
+
+  if (file < 0) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  struct stat status = {};
+  fstat(file, &status);
+  size_t length = static_cast<size_t>(status.st_size);
+
+  if (length < sizeof(binary::header)) {
+    close(file);
+    throw std::runtime_error("Invalid point file '" + path + "'");
+  }
+
+  // The mapping is private so the pages stay shared with the page cache (and
+  // other processes mapping the same file) as long as nobody writes them.
+  void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       file, 0);
+  close(file);
+
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("Can't map '" + path + "'");
+  }
+
+  const char *bytes = static_cast<const char *>(address);
+
+  header header = {};
+  std::memcpy(&header, bytes, sizeof(header));
+
+  try {
+    validate(header, length, path);
+  } catch (...) {
+    munmap(address, length);
+    throw;
+  }
+
+  *amount = static_cast<uint32_t>(header.amount);
+  *dimension = static_cast<uint32_t>(header.dimension);
+
+  if (native(header)) {
+    real *points = reinterpret_cast<real *>(static_cast<char *>(address) +
+                                            header.offset);
+    mappings.push_back({points, address, length});
+    return points;
+  }
+
+  real *points = new real[static_cast<size_t>(*amount) * *dimension];
+  convert(bytes + header.offset, header, *amount, points);
+  munmap(address, length);
+
+  return points;
+#endif
+}
+
+void write(const std::string &path,
+           real *points,
+           uint32_t amount,
+           uint32_t dimension,
+           binary::dtype dtype)
+{
+  if (!little_endian()) {
+    throw std::runtime_error("Point files need a little endian host");
+  }
+
+  std::ofstream file(path, std::ios::binary);
+
+  if (!file) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  header header = describe(amount, dimension, dtype);
+  auto padding = std::vector<char>(alignment - sizeof(header));
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+  if (dtype == real_dtype) {
+    file.write(reinterpret_cast<const char *>(points),
+               static_cast<std::streamsize>(static_cast<size_t>(amount) *
+                                            dimension * sizeof(real)));
+  } else {
+    auto floats = std::vector<float>(dimension);
+    auto doubles = std::vector<double>(dimension);
+
+    for (uint32_t i = 0; i < amount; i++) {
+      real *point = points + static_cast<size_t>(i) * dimension;
+
+      if (dtype == dtype::float32) {
+        std::copy_n(point, dimension, floats.begin());
+        file.write(reinterpret_cast<const char *>(floats.data()),
+                   static_cast<std::streamsize>(dimension * sizeof(float)));
+      } else {
+        std::copy_n(point, dimension, doubles.begin());
+        file.write(reinterpret_cast<const char *>(doubles.data()),
+                   static_cast<std::streamsize>(dimension * sizeof(double)));
+      }
+    }
+  }
+
+  if (!file) {
+    throw std::runtime_error("Can't write '" + path + "'");
+  }
+}
+
+bool release(real *points)
+{
+  auto position = std::find_if(mappings.begin(), mappings.end(),
+                               [points](const mapping &mapping) {
+                                 return mapping.points == points;
+                               });
+
+  if (position == mappings.end()) {
+    return false;
+  }
+
+#ifndef _WIN32
+  munmap(position->address, position->length);
+#endif
+  mappings.erase(position);
+
+  return true;
+}
+
+}
+}
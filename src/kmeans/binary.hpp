@@ -0,0 +1,96 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kmeans {
+namespace binary {
+
+// Binary point files store the points row-major behind a fixed header so they
+// can be mapped into memory instead of parsed. All fields and values are
+// little endian; big endian hosts can't read or write point files.
+//
+//   offset  size  field
+//        0     8  magic ("KMEANSPT")
+//        8     4  version (1)
+//       12     4  dtype (0 = float64, 1 = float32)
+//       16     8  amount of points
+//       24     8  dimension of the points
+//       32     8  offset of the first point in bytes (a multiple of alignment)
+//       40     8  stride between points in values (at least the dimension)
+//       48     8  alignment of the first point in bytes
+//       56     8  reserved (0)
+//
+// The bytes between the header and the first point and between the end of a
+// point and the start of the next one are padding.
+
+enum class dtype : uint32_t { float64 = 0, float32 = 1 };
+
+struct header {
+  char magic[8];
+  uint32_t version;
+  binary::dtype dtype;
+  uint64_t amount;
+  uint64_t dimension;
+  uint64_t offset;
+  uint64_t stride;
+  uint64_t alignment;
+  uint64_t reserved;
+};
+
+// Dtype of real, the dtype of points that can be used as they are stored.
+#ifdef KMEANS_FLOAT
+const binary::dtype real_dtype = dtype::float32;
+#else
+const binary::dtype real_dtype = dtype::float64;
+#endif
+
+// Alignment of the first point written by write(). A page so the points of a
+// mapped file start on a page and every SIMD load is naturally aligned.
+const uint64_t alignment = 4096;
+
+// Header of amount unpadded points of the given dtype as written by write(),
+// with the first point at alignment.
+header describe(uint64_t amount, uint64_t dimension, binary::dtype dtype);
+
+// Size in bytes of a value of the given dtype.
+size_t size(binary::dtype dtype);
+
+// Whether the points described by header are stored unpadded as reals, so
+// they can be used as they are stored.
+bool native(const header &header);
+
+// Converts amount points that are stored as described by header and start at
+// bytes into the amount * dimension array points.
+void convert(const char *bytes,
+             const header &header,
+             uint32_t amount,
+             real *points);
+
+// Whether the file at path starts with the magic of a binary point file.
+bool detect(const std::string &path);
+
+// Reads and validates the header of the binary point file at path.
+header inspect(const std::string &path);
+
+// Maps the points of the binary point file at path. The points are used in
+// place when the file stores unpadded points of the real type and are
+// converted into a new array otherwise. Release them with release().
+real *read(const std::string &path, uint32_t *amount, uint32_t *dimension);
+
+// Writes amount points to a binary point file at path with the given dtype.
+void write(const std::string &path,
+           real *points,
+           uint32_t amount,
+           uint32_t dimension,
+           binary::dtype dtype);
+
+// Unmaps points returned by read() and returns true, or returns false if the
+// points weren't mapped by read().
+bool release(real *points);
+
+}
+}
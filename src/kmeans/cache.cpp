@@ -0,0 +1,136 @@
+#include <kmeans/cache.hpp>
+
+#include <kmeans/binary.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace kmeans {
+namespace cache {
+
+static const char magic[8] = {'K', 'M', 'E', 'A', 'N', 'S', 'C', 'S'};
+
+static_assert(sizeof(binary::header) == key_offset,
+              "The key follows the header");
+static_assert(key_offset + sizeof(key) <= binary::alignment,
+              "The key fits in the padding before the points");
+
+bool enabled()
+{
+  const char *value = std::getenv("KMEANS_CACHE");
+  return value != nullptr && std::string(value) == "1";
+}
+
+std::string path(const std::string &input)
+{
+  return input + ".kmeans";
+}
+
+std::string temporary(const std::string &input, long id)
+{
+  return path(input) + ".tmp" + std::to_string(id);
+}
+
+// Nanoseconds of the modification time in status, which st_mtime leaves out.
+static int64_t nanoseconds(const struct stat &status)
+{
+#if defined(_WIN32)
+  (void)status;
+  return 0;
+#elif defined(__APPLE__)
+  return static_cast<int64_t>(status.st_mtimespec.tv_nsec);
+#else
+  return static_cast<int64_t>(status.st_mtim.tv_nsec);
+#endif
+}
+
+key stamp(const std::string &input)
+{
+  struct stat status = {};
+
+  if (stat(input.c_str(), &status) != 0) {
+    throw std::runtime_error("Can't open '" + input + "'");
+  }
+
+  key key = {};
+  std::memcpy(key.magic, magic, sizeof(magic));
+  key.size = static_cast<uint64_t>(status.st_size);
+  key.modified = static_cast<int64_t>(status.st_mtime);
+  key.modified_nanoseconds = nanoseconds(status);
+
+  return key;
+}
+
+bool valid(const std::string &input)
+{
+  std::string cache = path(input);
+
+  if (!binary::detect(cache)) {
+    return false;
+  }
+
+  try {
+    if (!binary::native(binary::inspect(cache))) {
+      return false;
+    }
+  } catch (const std::runtime_error &) {
+    return false;
+  }
+
+  std::ifstream file(cache, std::ios::binary);
+  key cached = {};
+
+  file.seekg(static_cast<std::streamoff>(key_offset));
+  file.read(reinterpret_cast<char *>(&cached), sizeof(cached));
+
+  key current = stamp(input);
+
+  return file && std::memcmp(cached.magic, current.magic, sizeof(magic)) == 0 &&
+         cached.size == current.size && cached.modified == current.modified &&
+         cached.modified_nanoseconds == current.modified_nanoseconds;
+}
+
+void store(const std::string &input,
+           real *points,
+           uint32_t amount,
+           uint32_t dimension)
+{
+#ifdef _WIN32
+  std::string written = temporary(input, _getpid());
+#else
+  std::string written = temporary(input, getpid());
+#endif
+
+  try {
+    binary::write(written, points, amount, dimension, binary::real_dtype);
+  } catch (const std::runtime_error &) {
+    std::remove(written.c_str());
+    return;
+  }
+
+  key key = stamp(input);
+  std::fstream file(written, std::ios::binary | std::ios::in | std::ios::out);
+
+  file.seekp(static_cast<std::streamoff>(key_offset));
+  file.write(reinterpret_cast<const char *>(&key), sizeof(key));
+  file.close();
+
+  // Renaming only makes complete caches visible to other processes.
+  if (!file || std::rename(written.c_str(), path(input).c_str()) != 0) {
+    std::remove(written.c_str());
+  }
+}
+
+}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace kmeans {
+namespace cache {
+
+// Opt-in cache of parsed CSV input, enabled by setting the KMEANS_CACHE
+// environment variable to 1. The first load of a CSV file writes the parsed
+// points to a binary point file next to it (see binary.hpp) and later loads map
+// that file instead of parsing the CSV file again. The size and modification
+// time of the CSV file are stored as a key in the padding after the header of
+// the cache, so the cache is ignored and rewritten once the CSV file changes.
+
+struct key {
+  char magic[8];
+  uint64_t size;
+  int64_t modified;
+
+  // Nanoseconds of the modification time, 0 where stat() only has seconds
+  // (Windows).
+  int64_t modified_nanoseconds;
+};
+
+// Offset of the key in the cache, right after the header.
+const uint64_t key_offset = 64;
+
+bool enabled();
+
+// Path of the cache of the CSV file at input.
+std::string path(const std::string &input);
+
+// Path to write the cache of input to before it is renamed to path(input),
+// unique for the given id (e.g. a process id).
+std::string temporary(const std::string &input, long id);
+
+// Key of the CSV file at input as it is now.
+key stamp(const std::string &input);
+
+// Whether path(input) holds the points of the CSV file at input as it is now.
+bool valid(const std::string &input);
+
+// Writes amount points parsed from the CSV file at input to path(input). The
+// cache is only an optimization so it is skipped when it can't be written.
+void store(const std::string &input,
+           real *points,
+           uint32_t amount,
+           uint32_t dimension);
+
+}
+}
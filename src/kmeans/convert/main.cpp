@@ -0,0 +1,61 @@
+#include <kmeans/binary.hpp>
+#include <kmeans/io.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Converts a CSV file of points into a binary point file (see binary.hpp):
+//
+//   convert --input points.csv --output points.bin [--dtype float64|float32]
+//
+// The dtype defaults to the precision the binaries are built with.
+static std::string argument(const std::vector<std::string> &raw_args,
+                            const std::string &argument,
+                            const std::string &fallback)
+{
+  auto position = std::find(raw_args.begin(), raw_args.end(), argument);
+
+  if (position != raw_args.end() && ++position != raw_args.end()) {
+    return *position;
+  }
+
+  return fallback;
+}
+
+int main(int argc, char *argv[])
+{
+  auto raw_args = std::vector<std::string>(argv + 1, argv + argc);
+
+#ifdef KMEANS_FLOAT
+  std::string fallback = "float32";
+#else
+  std::string fallback = "float64";
+#endif
+
+  std::string input = argument(raw_args, "--input", "");
+  std::string output = argument(raw_args, "--output", "");
+  std::string dtype = argument(raw_args, "--dtype", fallback);
+
+  if (input.empty() || output.empty() ||
+      (dtype != "float64" && dtype != "float32")) {
+    std::cerr << "Usage: convert --input points.csv --output points.bin "
+                 "[--dtype float64|float32]"
+              << std::endl;
+    return 1;
+  }
+
+  uint32_t amount;
+  uint32_t dimension;
+  kmeans::real *points = kmeans::io::input(input, &amount, &dimension);
+
+  kmeans::binary::write(output, points, amount, dimension,
+                        dtype == "float32" ? kmeans::binary::dtype::float32
+                                           : kmeans::binary::dtype::float64);
+  kmeans::io::release(points);
+
+  std::cout << amount << " points of dimension " << dimension << std::endl;
+
+  return 0;
+}
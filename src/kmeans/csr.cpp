@@ -0,0 +1,165 @@
+#include <kmeans/csr.hpp>
+
+#include <kmeans/gemm.hpp>
+#include <kmeans/random.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace kmeans {
+namespace csr {
+
+matrix allocate(uint32_t amount, uint64_t nonzeros)
+{
+  matrix points;
+  points.offsets = new uint64_t[static_cast<size_t>(amount) + 1];
+  points.indices = new uint32_t[nonzeros];
+  points.values = new real[nonzeros];
+  points.norms = new double[amount];
+  points.offsets[0] = 0;
+
+  return points;
+}
+
+matrix slice(const matrix &points, uint32_t first)
+{
+  matrix slice = points;
+  slice.offsets += first;
+  slice.norms += first;
+
+  return slice;
+}
+
+void norms(const matrix &points, uint32_t amount)
+{
+#pragma omp parallel for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    double norm = 0;
+
+    for (uint64_t j = points.offsets[i]; j < points.offsets[i + 1]; j++) {
+      norm += static_cast<double>(points.values[j]) * points.values[j];
+    }
+
+    points.norms[i] = norm;
+  }
+}
+
+void release(const matrix &points)
+{
+  delete[] points.offsets;
+  delete[] points.indices;
+  delete[] points.values;
+  delete[] points.norms;
+}
+
+uint16_t nearest(const matrix &points,
+                 uint32_t i,
+                 uint16_t cluster,
+                 real *centroids,
+                 double *centroid_norms,
+                 uint16_t clusters,
+                 uint32_t dimension)
+{
+  uint16_t previous_cluster = cluster;
+  double lowest_distance = distance(points, i,
+                                    centroids + cluster * dimension,
+                                    centroid_norms[cluster]);
+
+  for (uint16_t j = 0; j < clusters; j++) {
+    if (j == previous_cluster) {
+      continue;
+    }
+
+    double distance = csr::distance(points, i, centroids + j * dimension,
+                                    centroid_norms[j]);
+
+    if (distance < lowest_distance) {
+      cluster = j;
+      lowest_distance = distance;
+    }
+  }
+
+  return cluster;
+}
+
+void accumulate(double *sum, const matrix &points, uint32_t i)
+{
+  for (uint64_t j = points.offsets[i]; j < points.offsets[i + 1]; j++) {
+    sum[points.indices[j]] += points.values[j];
+  }
+}
+
+void copy(const matrix &points, uint32_t i, real *point, uint32_t dimension)
+{
+  std::fill_n(point, dimension, 0);
+
+  for (uint64_t j = points.offsets[i]; j < points.offsets[i + 1]; j++) {
+    point[points.indices[j]] = points.values[j];
+  }
+}
+
+void centroids(const matrix &points,
+               real *centroids,
+               uint32_t *centroid_point_indices,
+               uint16_t clusters,
+               uint32_t dimension,
+               std::uniform_int_distribution<uint32_t> *dist,
+               std::mt19937 *mt)
+{
+  random::indices(centroid_point_indices, clusters, dist, mt);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    copy(points, centroid_point_indices[i], centroids + i * dimension,
+         dimension);
+  }
+}
+
+void kmeanspp(const matrix &points,
+              real *centroids,
+              uint32_t *centroid_point_indices,
+              uint32_t amount,
+              uint16_t clusters,
+              uint32_t dimension,
+              std::uniform_int_distribution<uint32_t> *dist,
+              std::mt19937 *mt)
+{
+  auto point_distances = std::vector<double>(amount);
+  double total = 0;
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    uint32_t random_point = (*dist)(*mt);
+
+    if (i > 0 && total > 0) {
+      random_point = random::weighted(point_distances.data(), amount, total,
+                                      mt);
+    }
+
+    centroid_point_indices[i] = random_point;
+
+    real *centroid = centroids + i * dimension;
+    copy(points, random_point, centroid, dimension);
+
+    if (i + 1 == clusters) {
+      break;
+    }
+
+    double centroid_norm;
+    gemm::norms(centroid, &centroid_norm, 1, dimension);
+
+    total = 0;
+
+#pragma omp parallel for reduction(+ : total) schedule(static)
+    for (uint32_t j = 0; j < amount; j++) {
+      double distance = csr::distance(points, j, centroid, centroid_norm);
+
+      if (i == 0 || distance < point_distances[j]) {
+        point_distances[j] = distance;
+      }
+
+      total += point_distances[j];
+    }
+  }
+}
+
+}
+}
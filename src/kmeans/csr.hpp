@@ -0,0 +1,88 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+#include <random>
+
+namespace kmeans {
+namespace csr {
+
+// Sparse points in compressed sparse row layout. The nonzero values of point i
+// are values[offsets[i]] up to values[offsets[i + 1]] and their coordinates are
+// at the same positions in indices. The squared norm of every point is kept in
+// norms so a distance only has to go over the nonzero values of the point.
+struct matrix {
+  uint64_t *offsets = nullptr;
+  uint32_t *indices = nullptr;
+  real *values = nullptr;
+  double *norms = nullptr;
+};
+
+// Allocates amount points with nonzeros values in total. Only the first offset
+// is set. Release them with release().
+matrix allocate(uint32_t amount, uint64_t nonzeros);
+
+// The points of a matrix starting at point first. Shares the arrays of points.
+matrix slice(const matrix &points, uint32_t first);
+
+// Stores the squared norm of amount points in their norms.
+void norms(const matrix &points, uint32_t amount);
+
+void release(const matrix &points);
+
+// Squared distance between point i and a centroid with the given squared norm,
+// computed as ||x||^2 - 2 x.c + ||c||^2 over the nonzero values of the point.
+inline double distance(const matrix &points,
+                       uint32_t i,
+                       real *centroid,
+                       double centroid_norm)
+{
+  double dot = 0;
+
+  for (uint64_t j = points.offsets[i]; j < points.offsets[i + 1]; j++) {
+    dot += static_cast<double>(points.values[j]) * centroid[points.indices[j]];
+  }
+
+  double distance = points.norms[i] - 2 * dot + centroid_norm;
+
+  // Rounding can make the distance of a point to itself slightly negative.
+  return distance > 0 ? distance : 0;
+}
+
+// Like lloyd::nearest() for point i of points with the squared norms of the
+// centroids in centroid_norms (see gemm::norms()).
+uint16_t nearest(const matrix &points,
+                 uint32_t i,
+                 uint16_t cluster,
+                 real *centroids,
+                 double *centroid_norms,
+                 uint16_t clusters,
+                 uint32_t dimension);
+
+// Adds point i to the double precision sum of a centroid.
+void accumulate(double *sum, const matrix &points, uint32_t i);
+
+// Stores point i as a dense point of the given dimension.
+void copy(const matrix &points, uint32_t i, real *point, uint32_t dimension);
+
+// Like random::centroids() and random::kmeanspp() for sparse points.
+void centroids(const matrix &points,
+               real *centroids,
+               uint32_t *centroid_point_indices,
+               uint16_t clusters,
+               uint32_t dimension,
+               std::uniform_int_distribution<uint32_t> *dist,
+               std::mt19937 *mt);
+
+void kmeanspp(const matrix &points,
+              real *centroids,
+              uint32_t *centroid_point_indices,
+              uint32_t amount,
+              uint16_t clusters,
+              uint32_t dimension,
+              std::uniform_int_distribution<uint32_t> *dist,
+              std::mt19937 *mt);
+
+}
+}
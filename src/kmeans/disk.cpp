@@ -0,0 +1,135 @@
+#include <kmeans/disk.hpp>
+
+#include <kmeans/binary.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace kmeans {
+namespace disk {
+
+uint32_t window(uint32_t dimension)
+{
+  return static_cast<uint32_t>(
+      std::max<size_t>(window_size / (dimension * sizeof(real)), 1));
+}
+
+void check(const std::string &path)
+{
+#ifdef _WIN32
+  throw std::runtime_error("Out-of-core mode isn't supported on Windows");
+#else
+  if (!binary::detect(path) || !binary::native(binary::inspect(path))) {
+    throw std::runtime_error("Out-of-core input '" + path +
+                             "' needs to be a binary point file with "
+                             "unpadded points of the build's precision");
+  }
+#endif
+}
+
+#ifndef _WIN32
+// Gives advice on the pages of points [first, last). Only whole pages are
+// dropped so the pages shared with the neighbouring windows are kept.
+static void advise(real *points,
+                   uint32_t first,
+                   uint32_t last,
+                   uint32_t dimension,
+                   int advice)
+{
+  auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto begin = reinterpret_cast<uintptr_t>(points +
+                                           static_cast<size_t>(first) *
+                                               dimension);
+  auto end = reinterpret_cast<uintptr_t>(points +
+                                         static_cast<size_t>(last) *
+                                             dimension);
+
+  if (advice == MADV_DONTNEED) {
+    begin = (begin + page - 1) / page * page;
+    end = end / page * page;
+  } else {
+    begin = begin / page * page;
+  }
+
+  if (begin < end) {
+    madvise(reinterpret_cast<void *>(begin), end - begin, advice);
+  }
+}
+#endif
+
+void advance(real *points,
+             uint32_t first,
+             uint32_t window,
+             uint32_t amount,
+             uint32_t dimension)
+{
+#ifndef _WIN32
+  uint32_t next = first + window;
+
+  if (next < amount) {
+    advise(points, next, std::min(next + window, amount), dimension,
+           MADV_WILLNEED);
+  }
+
+  if (first >= window) {
+    advise(points, first - window, first, dimension, MADV_DONTNEED);
+  }
+#endif
+}
+
+uint16_t *clusters(const std::string &directory, uint32_t amount)
+{
+#ifdef _WIN32
+  return new uint16_t[amount]();
+#else
+  std::string pattern = directory + "/kmeans-clusters-XXXXXX";
+  auto name = std::vector<char>(pattern.begin(), pattern.end());
+  name.push_back('\0');
+
+  int file = mkstemp(name.data());
+
+  if (file < 0) {
+    throw std::runtime_error("Can't create a file in '" + directory + "'");
+  }
+
+  unlink(name.data());
+
+  size_t length = std::max<size_t>(amount * sizeof(uint16_t), 1);
+
+  if (ftruncate(file, static_cast<off_t>(length)) != 0) {
+    close(file);
+    throw std::runtime_error("Can't create a file in '" + directory + "'");
+  }
+
+  void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       file, 0);
+  close(file);
+
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("Can't map a file in '" + directory + "'");
+  }
+
+  return static_cast<uint16_t *>(address);
+#endif
+}
+
+void release(uint16_t *clusters, uint32_t amount)
+{
+#ifdef _WIN32
+  delete[] clusters;
+#else
+  if (clusters != nullptr) {
+    munmap(clusters, std::max<size_t>(amount * sizeof(uint16_t), 1));
+  }
+#endif
+}
+
+}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kmeans {
+namespace disk {
+
+// Out-of-core mode for points that don't fit in memory. The points stay in
+// the mapped binary point file (see binary.hpp) and every pass over them goes
+// window by window: while a window is used the OS already reads the next one
+// in the background and the one before it is dropped, so about two windows of
+// points are resident at a time. The clusters of the points are kept in files
+// as well.
+
+// Bytes of points per window.
+const size_t window_size = size_t(1) << 26;
+
+// Points per window for points of the given dimension.
+uint32_t window(uint32_t dimension);
+
+// Throws unless path is a binary point file that read() maps in place.
+void check(const std::string &path);
+
+// Called before the window of points starting at first is used in a pass
+// over amount mapped points.
+void advance(real *points,
+             uint32_t first,
+             uint32_t window,
+             uint32_t amount,
+             uint32_t dimension);
+
+// Allocates amount zeroed clusters in an unlinked file in directory, so the OS
+// can write them out instead of keeping them in memory.
+uint16_t *clusters(const std::string &directory, uint32_t amount);
+
+// Releases clusters allocated by clusters().
+void release(uint16_t *clusters, uint32_t amount);
+
+}
+}
@@ -1,17 +1,22 @@
 #include <kmeans/distance.hpp>
 
+#include <cmath>
+
 namespace kmeans {
 
-double distance(double *point, double *centroid, uint32_t dimension)
+void drift(real *previous_centroids,
+           real *centroids,
+           double *centroid_drifts,
+           uint16_t clusters,
+           uint32_t dimension)
 {
-  double total_distance = 0;
+  for (uint16_t i = 0; i < clusters; i++) {
+    real *previous_centroid = previous_centroids + i * dimension;
+    real *centroid = centroids + i * dimension;
 
-  for (uint32_t i = 0; i < dimension; i++) {
-    double distance = point[i] - centroid[i];
-    total_distance += distance * distance;
+    centroid_drifts[i] = std::sqrt(
+        distance(previous_centroid, centroid, dimension));
   }
-
-  return total_distance;
 }
 
 }
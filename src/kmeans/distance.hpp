@@ -1,9 +1,64 @@
 #pragma once
 
+#include <kmeans/fixed.hpp>
+#include <kmeans/real.hpp>
+#include <kmeans/simd.hpp>
+
 #include <cstdint>
 
 namespace kmeans {
 
-double distance(double *point, double *centroid, uint32_t dimension);
+// Squared distance between point and centroid. Defined inline so the loops
+// over the points switch into the kernel specialized on the dimension without
+// a call. Other dimensions use the vectorized kernel of the instruction set
+// level detected at startup.
+inline double distance(real *point, real *centroid, uint32_t dimension)
+{
+  switch (dimension) {
+    case 2:
+      return fixed::distance<2>(point, centroid);
+    case 3:
+      return fixed::distance<3>(point, centroid);
+    case 4:
+      return fixed::distance<4>(point, centroid);
+    case 8:
+      return fixed::distance<8>(point, centroid);
+    case 16:
+      return fixed::distance<16>(point, centroid);
+    default:
+      break;
+  }
+
+  return simd::selected().distance(point, centroid, dimension);
+}
+
+// Adds point to the double precision sum of a centroid.
+inline void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  switch (dimension) {
+    case 2:
+      return fixed::accumulate<2>(sum, point);
+    case 3:
+      return fixed::accumulate<3>(sum, point);
+    case 4:
+      return fixed::accumulate<4>(sum, point);
+    case 8:
+      return fixed::accumulate<8>(sum, point);
+    case 16:
+      return fixed::accumulate<16>(sum, point);
+    default:
+      break;
+  }
+
+  simd::selected().accumulate(sum, point, dimension);
+}
+
+// Stores the (non-squared) distance each centroid moved between
+// previous_centroids and centroids in centroid_drifts.
+void drift(real *previous_centroids,
+           real *centroids,
+           double *centroid_drifts,
+           uint16_t clusters,
+           uint32_t dimension);
 
 }
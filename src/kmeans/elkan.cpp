@@ -0,0 +1,95 @@
+#include <kmeans/elkan.hpp>
+
+#include <kmeans/distance.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace kmeans {
+namespace elkan {
+
+void centroids(real *centroids,
+               double *centroid_distances,
+               double *centroid_bounds,
+               uint16_t clusters,
+               uint32_t dimension)
+{
+  std::fill_n(centroid_bounds, clusters, std::numeric_limits<double>::max());
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    real *first = centroids + i * dimension;
+    centroid_distances[i * clusters + i] = 0;
+
+    for (uint16_t j = static_cast<uint16_t>(i + 1); j < clusters; j++) {
+      real *second = centroids + j * dimension;
+      double half = std::sqrt(kmeans::distance(first, second, dimension)) / 2;
+
+      centroid_distances[i * clusters + j] = half;
+      centroid_distances[j * clusters + i] = half;
+
+      centroid_bounds[i] = std::min(centroid_bounds[i], half);
+      centroid_bounds[j] = std::min(centroid_bounds[j], half);
+    }
+  }
+}
+
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 double *centroid_distances,
+                 double *centroid_bounds,
+                 double *centroid_drifts,
+                 double *upper_bound,
+                 double *lower_bounds,
+                 uint16_t clusters,
+                 uint32_t dimension)
+{
+  for (uint16_t j = 0; j < clusters; j++) {
+    lower_bounds[j] = std::max(lower_bounds[j] - centroid_drifts[j], 0.0);
+  }
+
+  double upper = *upper_bound + centroid_drifts[cluster];
+
+  if (upper <= centroid_bounds[cluster]) {
+    *upper_bound = upper;
+    return cluster;
+  }
+
+  bool tight = false;
+
+  for (uint16_t j = 0; j < clusters; j++) {
+    if (j == cluster || upper <= lower_bounds[j] ||
+        upper <= centroid_distances[cluster * clusters + j]) {
+      continue;
+    }
+
+    if (!tight) {
+      real *centroid = centroids + cluster * dimension;
+      upper = std::sqrt(kmeans::distance(point, centroid, dimension));
+      lower_bounds[cluster] = upper;
+      tight = true;
+
+      if (upper <= lower_bounds[j] ||
+          upper <= centroid_distances[cluster * clusters + j]) {
+        continue;
+      }
+    }
+
+    real *centroid = centroids + j * dimension;
+    double distance = std::sqrt(kmeans::distance(point, centroid, dimension));
+    lower_bounds[j] = distance;
+
+    if (distance < upper) {
+      cluster = j;
+      upper = distance;
+    }
+  }
+
+  *upper_bound = upper;
+
+  return cluster;
+}
+
+}
+}
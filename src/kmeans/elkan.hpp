@@ -0,0 +1,36 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+
+namespace kmeans {
+namespace elkan {
+
+// Stores half the distance between every pair of centroids in
+// centroid_distances (clusters * clusters) and half the distance from each
+// centroid to its nearest other centroid in centroid_bounds (clusters).
+void centroids(real *centroids,
+               double *centroid_distances,
+               double *centroid_bounds,
+               uint16_t clusters,
+               uint32_t dimension);
+
+// Returns the nearest centroid of point using Elkan's triangle inequality
+// bounds. upper_bound points to the upper bound on the distance of point to
+// its current centroid and lower_bounds to the lower bounds on its distance to
+// every centroid. Both are first moved by the drift of the centroids since the
+// previous assignment and are tightened as distances are computed.
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 double *centroid_distances,
+                 double *centroid_bounds,
+                 double *centroid_drifts,
+                 double *upper_bound,
+                 double *lower_bounds,
+                 uint16_t clusters,
+                 uint32_t dimension);
+
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+
+namespace kmeans {
+namespace fixed {
+
+// Kernels specialized on the dimension of the points for the dimensions most
+// datasets have (2, 3, 4, 8 and 16). The trip count of every loop is known at
+// compile time so the compiler unrolls them completely and keeps the point in
+// registers instead of paying for a loop with a runtime trip count per
+// distance.
+
+template <uint32_t dimension>
+inline double distance(real *point, real *centroid)
+{
+  double total_distance = 0;
+
+  for (uint32_t i = 0; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+template <uint32_t dimension>
+inline void accumulate(double *sum, real *point)
+{
+  for (uint32_t i = 0; i < dimension; i++) {
+    sum[i] += point[i];
+  }
+}
+
+// Lloyd's nearest centroid (see lloyd::nearest) with the point copied into
+// registers once for all centroids.
+template <uint32_t dimension>
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 uint16_t clusters)
+{
+  real registers[dimension];
+
+  for (uint32_t i = 0; i < dimension; i++) {
+    registers[i] = point[i];
+  }
+
+  double lowest_distance = distance<dimension>(
+      registers, centroids + cluster * dimension);
+
+  for (uint16_t j = 0; j < clusters; j++) {
+    double distance = fixed::distance<dimension>(registers,
+                                                 centroids + j * dimension);
+
+    if (distance < lowest_distance) {
+      cluster = j;
+      lowest_distance = distance;
+    }
+  }
+
+  return cluster;
+}
+
+}
+}
@@ -0,0 +1,222 @@
+#include <kmeans/gemm.hpp>
+
+#include <kmeans/accumulation.hpp>
+#include <kmeans/simd.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace kmeans {
+namespace gemm {
+
+// Points per cache block. Every panel is streamed over a whole block of points
+// so each packed centroid is loaded once per block instead of once per point.
+static const uint32_t block = 256;
+
+void norms(real *vectors, double *norms, uint32_t amount, uint32_t dimension)
+{
+#pragma omp parallel for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    real *vector = vectors + static_cast<size_t>(i) * dimension;
+    double norm = 0;
+
+    for (uint32_t j = 0; j < dimension; j++) {
+      double value = vector[j];
+      norm += value * value;
+    }
+
+    norms[i] = norm;
+  }
+}
+
+size_t packed_size(uint16_t clusters, uint32_t dimension)
+{
+  size_t panels = (clusters + panel - 1) / panel;
+  return panels * panel * dimension;
+}
+
+void centroids(real *centroids,
+               double *centroid_norms,
+               real *packed_centroids,
+               uint16_t clusters,
+               uint32_t dimension)
+{
+  norms(centroids, centroid_norms, clusters, dimension);
+
+  std::fill_n(packed_centroids, packed_size(clusters, dimension), 0);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    real *centroid = centroids + i * dimension;
+    real *packed = packed_centroids + (i / panel) * panel * dimension;
+
+    for (uint32_t j = 0; j < dimension; j++) {
+      packed[j * panel + i % panel] = centroid[j];
+    }
+  }
+}
+
+namespace team {
+
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension,
+            accumulation::buffer *buffer,
+            double *centroid_sums,
+            uint32_t *cluster_sizes,
+            bool moved)
+{
+  const simd::kernels &kernels = simd::selected();
+
+  uint32_t panels = (clusters + panel - 1) / panel;
+  uint32_t blocks = (amount + block - 1) / block;
+
+  bool point_clusters_equal = true;
+  accumulation::part part = {};
+
+  if (buffer != nullptr) {
+    accumulation::team::reserve(buffer, clusters, dimension);
+    part = accumulation::begin(buffer, clusters, dimension, moved);
+  }
+
+#pragma omp for schedule(static)
+  for (uint32_t j = 0; j < blocks; j++) {
+    uint32_t first = j * block;
+    uint32_t count = std::min(block, amount - first);
+
+    double lowest_distances[block];
+    double previous_distances[block];
+    uint16_t nearest_clusters[block];
+
+    std::fill_n(lowest_distances, count, std::numeric_limits<double>::max());
+    std::fill_n(previous_distances, count, std::numeric_limits<double>::max());
+    std::fill_n(nearest_clusters, count, 0);
+
+    for (uint32_t p = 0; p < panels; p++) {
+      real *panel_centroids = packed_centroids +
+                                static_cast<size_t>(p) * panel * dimension;
+      uint32_t columns = std::min(panel, clusters - p * panel);
+
+      for (uint32_t t = 0; t < count; t += tile) {
+        real *tile_points[tile];
+        double dots[tile * panel];
+
+        // The last point is repeated to fill a partial tile so the kernel
+        // doesn't need a remainder loop.
+        for (uint32_t a = 0; a < tile; a++) {
+          uint32_t i = first + std::min(t + a, count - 1);
+          tile_points[a] = points + static_cast<size_t>(i) * dimension;
+        }
+
+        kernels.tile(tile_points, panel_centroids, dots, dimension);
+
+        for (uint32_t a = 0; a < tile && t + a < count; a++) {
+          uint32_t i = t + a;
+          uint16_t previous_cluster = point_clusters[first + i];
+
+          for (uint32_t b = 0; b < columns; b++) {
+            uint16_t cluster = static_cast<uint16_t>(p * panel + b);
+            double distance = point_norms[first + i] -
+                              2 * dots[a * panel + b] +
+                              centroid_norms[cluster];
+
+            if (cluster == previous_cluster) {
+              previous_distances[i] = distance;
+            }
+
+            if (distance < lowest_distances[i]) {
+              lowest_distances[i] = distance;
+              nearest_clusters[i] = cluster;
+            }
+          }
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint16_t previous_cluster = point_clusters[first + i];
+      uint16_t cluster = previous_distances[i] <= lowest_distances[i]
+                             ? previous_cluster
+                             : nearest_clusters[i];
+
+      point_clusters_equal = point_clusters_equal &&
+                             previous_cluster == cluster;
+      point_clusters[first + i] = cluster;
+
+      // The points of the block are still cached from the tiles.
+      if (buffer != nullptr) {
+        accumulation::add(
+            part, previous_cluster, cluster,
+            points + static_cast<size_t>(first + i) * dimension, dimension);
+      }
+    }
+  }
+
+  if (buffer != nullptr) {
+    accumulation::end(buffer, centroid_sums, cluster_sizes, clusters,
+                      dimension);
+  }
+
+  return point_clusters_equal;
+}
+
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension)
+{
+  return assign(points, point_norms, point_clusters, amount, packed_centroids,
+                centroid_norms, clusters, dimension, nullptr, nullptr,
+                nullptr, false);
+}
+
+}
+
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension,
+            accumulation::buffer *buffer,
+            double *centroid_sums,
+            uint32_t *cluster_sizes,
+            bool moved)
+{
+  bool point_clusters_equal = true;
+
+#pragma omp parallel reduction(min : point_clusters_equal)
+  point_clusters_equal = team::assign(
+      points, point_norms, point_clusters, amount, packed_centroids,
+      centroid_norms, clusters, dimension, buffer, centroid_sums,
+      cluster_sizes, moved);
+
+  return point_clusters_equal;
+}
+
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension)
+{
+  return assign(points, point_norms, point_clusters, amount, packed_centroids,
+                centroid_norms, clusters, dimension, nullptr, nullptr,
+                nullptr, false);
+}
+
+}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <kmeans/accumulation.hpp>
+#include <kmeans/real.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kmeans {
+namespace gemm {
+
+// Lloyd assignment formulated as a matrix multiplication. The squared
+// distance between a point x and a centroid c is expanded into
+// ||x||^2 - 2 x.c + ||c||^2 so the norms only have to be computed once per
+// dataset (points) or once per iteration (centroids) and the cross terms of a
+// block of points with every centroid are computed by a cache blocked,
+// register tiled matrix multiplication.
+
+// Centroids per packed panel and points per register tile. A tile keeps
+// tile * panel dot products in registers.
+const uint32_t panel = 8;
+const uint32_t tile = 4;
+
+// Stores the squared norm of amount vectors in norms (amount).
+void norms(real *vectors, double *norms, uint32_t amount, uint32_t dimension);
+
+// Amount of reals needed to store clusters packed centroids.
+size_t packed_size(uint16_t clusters, uint32_t dimension);
+
+// Stores the squared norm of each centroid in centroid_norms (clusters) and
+// packs the centroids in panels that are streamed by assign().
+void centroids(real *centroids,
+               double *centroid_norms,
+               real *packed_centroids,
+               uint16_t clusters,
+               uint32_t dimension);
+
+// Assigns each of amount points to its nearest centroid in point_clusters. A
+// point keeps its current cluster when another centroid is equally near.
+// Returns whether every point kept its current cluster.
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension);
+
+// Like assign() while adding every point to centroid_sums and cluster_sizes
+// with the fused accumulation of buffer (see accumulation.hpp), or only moving
+// the points that changed cluster when moved is set.
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension,
+            accumulation::buffer *buffer,
+            double *centroid_sums,
+            uint32_t *cluster_sizes,
+            bool moved);
+
+// Versions of assign() that are called by every thread of a parallel region
+// that is already open, like accumulation::team. Each thread returns whether
+// the points it assigned kept their cluster.
+namespace team {
+
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension);
+
+bool assign(real *points,
+            double *point_norms,
+            uint16_t *point_clusters,
+            uint32_t amount,
+            real *packed_centroids,
+            double *centroid_norms,
+            uint16_t clusters,
+            uint32_t dimension,
+            accumulation::buffer *buffer,
+            double *centroid_sums,
+            uint32_t *cluster_sizes,
+            bool moved);
+
+}
+
+}
+}
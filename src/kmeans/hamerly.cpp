@@ -0,0 +1,101 @@
+#include <kmeans/hamerly.hpp>
+
+#include <kmeans/distance.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace kmeans {
+namespace hamerly {
+
+void centroids(real *centroids,
+               double *centroid_bounds,
+               uint16_t clusters,
+               uint32_t dimension)
+{
+  std::fill_n(centroid_bounds, clusters, std::numeric_limits<double>::max());
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    real *first = centroids + i * dimension;
+
+    for (uint16_t j = static_cast<uint16_t>(i + 1); j < clusters; j++) {
+      real *second = centroids + j * dimension;
+      double half = std::sqrt(kmeans::distance(first, second, dimension)) / 2;
+
+      centroid_bounds[i] = std::min(centroid_bounds[i], half);
+      centroid_bounds[j] = std::min(centroid_bounds[j], half);
+    }
+  }
+}
+
+drift drifts(double *centroid_drifts, uint16_t clusters)
+{
+  drift drift = { 0, 0, 0 };
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    if (centroid_drifts[i] > drift.largest) {
+      drift.second = drift.largest;
+      drift.largest = centroid_drifts[i];
+      drift.cluster = i;
+    } else if (centroid_drifts[i] > drift.second) {
+      drift.second = centroid_drifts[i];
+    }
+  }
+
+  return drift;
+}
+
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 double *centroid_bounds,
+                 double *centroid_drifts,
+                 drift drift,
+                 double *upper_bound,
+                 double *lower_bound,
+                 uint16_t clusters,
+                 uint32_t dimension)
+{
+  double upper = *upper_bound + centroid_drifts[cluster];
+  double lower = *lower_bound -
+                 (cluster == drift.cluster ? drift.second : drift.largest);
+
+  double bound = std::max(centroid_bounds[cluster], lower);
+
+  if (upper > bound) {
+    real *centroid = centroids + cluster * dimension;
+    upper = std::sqrt(kmeans::distance(point, centroid, dimension));
+
+    if (upper > bound) {
+      uint16_t previous_cluster = cluster;
+      lower = std::numeric_limits<double>::max();
+
+      for (uint16_t j = 0; j < clusters; j++) {
+        if (j == previous_cluster) {
+          continue;
+        }
+
+        centroid = centroids + j * dimension;
+        double distance = std::sqrt(kmeans::distance(point, centroid,
+                                                     dimension));
+
+        if (distance < upper) {
+          lower = upper;
+          upper = distance;
+          cluster = j;
+        } else if (distance < lower) {
+          lower = distance;
+        }
+      }
+    }
+  }
+
+  *upper_bound = upper;
+  *lower_bound = lower;
+
+  return cluster;
+}
+
+}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+
+namespace kmeans {
+namespace hamerly {
+
+// The centroid that drifted the most together with its drift and the largest
+// drift of all other centroids.
+struct drift {
+  uint16_t cluster;
+  double largest;
+  double second;
+};
+
+// Stores half the distance from each centroid to its nearest other centroid
+// in centroid_bounds (clusters).
+void centroids(real *centroids,
+               double *centroid_bounds,
+               uint16_t clusters,
+               uint32_t dimension);
+
+drift drifts(double *centroid_drifts, uint16_t clusters);
+
+// Returns the nearest centroid of point using Hamerly's bounds. upper_bound
+// points to the upper bound on the distance of point to its current centroid
+// and lower_bound to the lower bound on its distance to every other centroid.
+// Both are first moved by the drift of the centroids since the previous
+// assignment and are recomputed when all distances have to be computed.
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 double *centroid_bounds,
+                 double *centroid_drifts,
+                 drift drift,
+                 double *upper_bound,
+                 double *lower_bound,
+                 uint16_t clusters,
+                 uint32_t dimension);
+
+}
+}
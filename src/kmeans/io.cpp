@@ -1,33 +1,110 @@
 #include <kmeans/io.hpp>
 
-#include <vector>
+#include <kmeans/binary.hpp>
+#include <kmeans/cache.hpp>
+
 #include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
 namespace kmeans {
 namespace io {
 
-std::vector<std::vector<double>> input(const std::string &input_csv_path)
+// Reads the points at path without going through the cache.
+static real *read(const std::string &path,
+                  uint32_t *amount,
+                  uint32_t *dimension)
 {
-  auto points = std::vector<std::vector<double>>();
+  if (binary::detect(path)) {
+    return binary::read(path, amount, dimension);
+  }
 
-  std::ifstream input_csv(input_csv_path);
-  auto reader = CSVReader(input_csv);
-  auto row = std::vector<double>();
+  return CSVReader(path).read(amount, dimension);
+}
+
+real *input(const std::string &input_csv_path,
+            uint32_t *amount,
+            uint32_t *dimension)
+{
+  if (!cache::enabled() || binary::detect(input_csv_path)) {
+    return read(input_csv_path, amount, dimension);
+  }
 
-  while (reader.read(row)) {
-    points.push_back(row);
+  if (cache::valid(input_csv_path)) {
+    return binary::read(cache::path(input_csv_path), amount, dimension);
   }
 
+  real *points = CSVReader(input_csv_path).read(amount, dimension);
+  cache::store(input_csv_path, points, *amount, *dimension);
+
   return points;
 }
 
+real *centroids(const std::string &path, uint16_t clusters, uint32_t dimension)
+{
+  uint32_t amount;
+  uint32_t centroid_dimension;
+  real *centroids = read(path, &amount, &centroid_dimension);
+
+  if (amount != clusters || centroid_dimension != dimension) {
+    release(centroids);
+    throw std::runtime_error("Expected " + std::to_string(clusters) +
+                             " centroids of dimension " +
+                             std::to_string(dimension) + " in '" + path +
+                             "'");
+  }
+
+  return centroids;
+}
+
+void release(real *points)
+{
+  if (!binary::release(points)) {
+    delete[] points;
+  }
+}
+
 void output(uint16_t *point_clusters,
             uint32_t amount,
-            const std::string &output_csv_path)
+            const std::string &output_path,
+            bool binary)
 {
-  std::ofstream output_csv(output_csv_path);
-  CSVWriter(output_csv)
-      .write(std::vector<double>(point_clusters, point_clusters + amount));
+  std::ofstream output(output_path, std::ios::binary);
+
+  if (binary) {
+    output.write(reinterpret_cast<const char *>(point_clusters),
+                 static_cast<std::streamsize>(amount * sizeof(uint16_t)));
+  } else {
+    CSVWriter(output).write(point_clusters, amount);
+  }
+
+  if (!output) {
+    throw std::runtime_error("Can't write '" + output_path + "'");
+  }
+}
+
+void output_centroids(real *centroids,
+                      uint16_t clusters,
+                      uint32_t dimension,
+                      double cost,
+                      const std::string &output_path)
+{
+  std::ofstream output(output_path);
+  output.precision(std::numeric_limits<double>::max_digits10);
+  output << "# cost " << cost << "\n";
+
+  // Enough digits to read back the exact same values.
+  CSVWriter writer(output, ',', std::numeric_limits<real>::max_digits10);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    real *centroid = centroids + i * dimension;
+    writer.write(std::vector<double>(centroid, centroid + dimension));
+  }
+
+  if (!output) {
+    throw std::runtime_error("Can't write '" + output_path + "'");
+  }
 }
 
 }
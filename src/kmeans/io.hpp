@@ -8,11 +8,35 @@
 namespace kmeans {
 namespace io {
 
-std::vector<std::vector<double>> input(const std::string &input_csv_path);
+// Reads the points in input_csv_path into an amount * dimension array. Binary
+// point files (see binary.hpp) are recognized by their magic and mapped instead
+// of parsed, like the cache of a CSV file when caching is enabled (see
+// cache.hpp).
+real *input(const std::string &input_csv_path,
+            uint32_t *amount,
+            uint32_t *dimension);
 
+// Reads clusters centroids of the given dimension from the input file at path
+// (e.g. written by output_centroids()). Release them with release().
+real *centroids(const std::string &path, uint16_t clusters, uint32_t dimension);
+
+// Releases points returned by input().
+void release(real *points);
+
+// Writes the cluster of every point to output_path, either as a single CSV row
+// or, if binary, as the raw array of amount uint16_t values.
 void output(uint16_t *point_clusters,
             uint32_t amount,
-            const std::string &output_csv_path);
+            const std::string &output_path,
+            bool binary);
+
+// Writes the centroids as CSV with a centroid per line, preceded by a comment
+// with the cost of the solution so the file can be read back as points.
+void output_centroids(real *centroids,
+                      uint16_t clusters,
+                      uint32_t dimension,
+                      double cost,
+                      const std::string &output_path);
 
 }
 }
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace kmeans {
+
+// The kernel used by Lloyd to compute the distances from the points to the
+// centroids. Direct computes each distance on its own while gemm expands the
+// distances into norms and dot products and computes the dot products of
+// blocks of points with all centroids as a matrix multiplication.
+enum class kernel { direct, gemm };
+
+}
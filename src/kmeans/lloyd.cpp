@@ -0,0 +1,62 @@
+#include <kmeans/lloyd.hpp>
+
+#include <kmeans/distance.hpp>
+#include <kmeans/fixed.hpp>
+
+namespace kmeans {
+namespace lloyd {
+
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 uint16_t clusters,
+                 uint32_t dimension)
+{
+  switch (dimension) {
+    case 2:
+      return fixed::nearest<2>(point, cluster, centroids, clusters);
+    case 3:
+      return fixed::nearest<3>(point, cluster, centroids, clusters);
+    case 4:
+      return fixed::nearest<4>(point, cluster, centroids, clusters);
+    case 8:
+      return fixed::nearest<8>(point, cluster, centroids, clusters);
+    case 16:
+      return fixed::nearest<16>(point, cluster, centroids, clusters);
+    default:
+      break;
+  }
+
+  uint16_t previous_cluster = cluster;
+
+  real *centroid = centroids + cluster * dimension;
+  double lowest_distance = kmeans::distance(point, centroid, dimension);
+
+  for (uint16_t j = 0; j < previous_cluster; j++) {
+    centroid = centroids + j * dimension;
+
+    double distance = kmeans::distance(point, centroid, dimension);
+
+    if (distance < lowest_distance) {
+      cluster = j;
+      lowest_distance = distance;
+    }
+  }
+
+  for (uint16_t j = static_cast<uint16_t>(previous_cluster + 1); j < clusters;
+       j++) {
+    centroid = centroids + j * dimension;
+
+    double distance = kmeans::distance(point, centroid, dimension);
+
+    if (distance < lowest_distance) {
+      cluster = j;
+      lowest_distance = distance;
+    }
+  }
+
+  return cluster;
+}
+
+}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+
+namespace kmeans {
+namespace lloyd {
+
+// Returns the nearest centroid of point by computing the distance to every
+// centroid. The current cluster is kept when another centroid is equally near.
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 uint16_t clusters,
+                 uint32_t dimension);
+
+}
+}
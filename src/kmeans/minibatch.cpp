@@ -0,0 +1,87 @@
+#include <kmeans/minibatch.hpp>
+
+#include <kmeans/distance.hpp>
+#include <kmeans/lloyd.hpp>
+
+#include <algorithm>
+
+namespace kmeans {
+namespace minibatch {
+
+void sample(uint32_t *batch_points,
+            uint32_t batch_size,
+            std::uniform_int_distribution<uint32_t> *dist,
+            std::mt19937 *mt)
+{
+  for (uint32_t i = 0; i < batch_size; i++) {
+    batch_points[i] = (*dist)(*mt);
+  }
+}
+
+void assign(real *points,
+            uint32_t *batch_points,
+            uint16_t *batch_clusters,
+            uint32_t batch_size,
+            real *centroids,
+            uint16_t clusters,
+            uint32_t dimension)
+{
+#pragma omp parallel for schedule(static)
+  for (uint32_t i = 0; i < batch_size; i++) {
+    real *point = points + static_cast<size_t>(batch_points[i]) * dimension;
+    batch_clusters[i] = lloyd::nearest(point, batch_clusters[i], centroids,
+                                       clusters, dimension);
+  }
+}
+
+void accumulate(real *points,
+                uint32_t *batch_points,
+                uint16_t *batch_clusters,
+                uint32_t batch_size,
+                double *batch_centroids,
+                uint32_t *batch_cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension)
+{
+  std::fill_n(batch_centroids, clusters * dimension, 0);
+  std::fill_n(batch_cluster_sizes, clusters, 0);
+
+  for (uint32_t i = 0; i < batch_size; i++) {
+    uint16_t cluster = batch_clusters[i];
+    batch_cluster_sizes[cluster]++;
+
+    real *point = points + static_cast<size_t>(batch_points[i]) * dimension;
+    double *batch_centroid = batch_centroids + cluster * dimension;
+
+    kmeans::accumulate(batch_centroid, point, dimension);
+  }
+}
+
+void update(real *centroids,
+            uint32_t *cluster_sizes,
+            double *batch_centroids,
+            uint32_t *batch_cluster_sizes,
+            uint16_t clusters,
+            uint32_t dimension)
+{
+  for (uint16_t i = 0; i < clusters; i++) {
+    if (batch_cluster_sizes[i] == 0) {
+      continue;
+    }
+
+    uint32_t previous_size = cluster_sizes[i];
+    cluster_sizes[i] += batch_cluster_sizes[i];
+
+    real *centroid = centroids + i * dimension;
+    double *batch_centroid = batch_centroids + i * dimension;
+
+    for (uint32_t j = 0; j < dimension; j++) {
+      double sum = static_cast<double>(centroid[j]) * previous_size +
+                   batch_centroid[j];
+      centroid[j] = static_cast<real>(sum / cluster_sizes[i]);
+    }
+  }
+}
+
+}
+}
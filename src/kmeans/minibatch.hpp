@@ -0,0 +1,52 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+#include <random>
+
+namespace kmeans {
+namespace minibatch {
+
+// Mini-batch k-means moves the centroids towards random batches of points
+// instead of recomputing them from every point in each iteration.
+
+// Stores batch_size random point indices in batch_points.
+void sample(uint32_t *batch_points,
+            uint32_t batch_size,
+            std::uniform_int_distribution<uint32_t> *dist,
+            std::mt19937 *mt);
+
+// Stores the nearest centroid of each batch point in batch_clusters.
+void assign(real *points,
+            uint32_t *batch_points,
+            uint16_t *batch_clusters,
+            uint32_t batch_size,
+            real *centroids,
+            uint16_t clusters,
+            uint32_t dimension);
+
+// Stores the sum of the batch points of each cluster in batch_centroids and
+// their amount in batch_cluster_sizes.
+void accumulate(real *points,
+                uint32_t *batch_points,
+                uint16_t *batch_clusters,
+                uint32_t batch_size,
+                double *batch_centroids,
+                uint32_t *batch_cluster_sizes,
+                uint16_t clusters,
+                uint32_t dimension);
+
+// Moves each centroid towards the batch points of its cluster with a
+// per-cluster learning rate of 1 / cluster_sizes, where cluster_sizes counts
+// every batch point assigned to the cluster so far. This keeps each centroid
+// at the mean of all batch points it was assigned.
+void update(real *centroids,
+            uint32_t *cluster_sizes,
+            double *batch_centroids,
+            uint32_t *batch_cluster_sizes,
+            uint16_t clusters,
+            uint32_t dimension);
+
+}
+}
@@ -1,15 +1,29 @@
 #include <kmeans/mpi-group/data.hpp>
 
+#include <kmeans/gemm.hpp>
+#include <kmeans/io.hpp>
+
+#include <algorithm>
+
 namespace kmeans {
 
-data::data(double *points,
+data::data(real *points,
+           const csr::matrix &sparse_points,
            uint32_t amount,
            uint16_t clusters,
            uint32_t dimension,
-           double *worker_points,
+           real *worker_points,
+           const csr::matrix &worker_sparse_points,
            uint32_t worker_amount,
            int processes,
-           int rank)
+           int rank,
+           kmeans::assignment assignment,
+           kmeans::kernel kernel,
+           kmeans::seeding seeding,
+           uint32_t batch_size,
+           uint32_t batch_iterations,
+           bool batch_refine,
+           uint32_t incremental)
     : points(points),
       amount(amount),
       clusters(clusters),
@@ -17,10 +31,24 @@ data::data(double *points,
       worker_points(worker_points),
       worker_amount(worker_amount),
       processes(processes),
-      rank(rank)
+      rank(rank),
+      sparse(worker_sparse_points.offsets != nullptr),
+      sparse_points(sparse_points),
+      worker_sparse_points(worker_sparse_points),
+      fused(accumulation::fused(clusters, dimension)),
+      incremental(fused ? incremental : 0),
+      assignment(assignment),
+      bounds(kmeans::bounds(assignment, clusters)),
+      kernel(kernel),
+      seeding(seeding),
+      batch_size(batch_size),
+      batch_iterations(batch_iterations),
+      batch_refine(batch_refine),
+      worker_batch_size(divide::amount(batch_size, processes, rank))
 {
   if (rank == 0) {
     lowest_cost_point_clusters = new uint16_t[amount]();
+    lowest_cost_centroids = new real[clusters * dimension]();
     centroid_point_indices = new uint32_t[clusters]();
 
     dist = new std::uniform_int_distribution<uint32_t>(0, amount - 1);
@@ -38,15 +66,75 @@ data::data(double *points,
   }
 
   worker_point_clusters = new uint16_t[worker_amount]();
-  worker_centroids = new double[clusters * dimension]();
+  worker_centroids = new real[clusters * dimension]();
+  previous_centroids = new real[clusters * dimension]();
+  centroid_sums = new double[clusters * dimension]();
   worker_cluster_sizes = new uint32_t[clusters]();
+
+  if (seeding == kmeans::seeding::scalable || batch_size > 0) {
+    // We use the rank as seed to avoid each process sampling the same
+    // candidates.
+    worker_mt = new std::mt19937(static_cast<uint64_t>(rank));
+  }
+
+  if (fused && incremental > 0) {
+    running_centroid_sums = new double[clusters * dimension]();
+    running_cluster_sizes = new uint32_t[clusters]();
+  }
+
+  if (assignment != kmeans::assignment::lloyd) {
+    worker_upper_bounds = new double[worker_amount]();
+    worker_lower_bounds =
+        new double[static_cast<size_t>(worker_amount) * bounds]();
+    centroid_drifts = new double[clusters]();
+  }
+
+  if (assignment == kmeans::assignment::elkan) {
+    centroid_distances = new double[static_cast<size_t>(clusters) * clusters]();
+  }
+
+  if (assignment == kmeans::assignment::elkan ||
+      assignment == kmeans::assignment::hamerly) {
+    centroid_bounds = new double[clusters]();
+  }
+
+  if (assignment == kmeans::assignment::yinyang) {
+    centroid_groups = new uint16_t[clusters]();
+    group_centroids = new uint16_t[clusters]();
+    group_offsets = new uint32_t[bounds + 1]();
+    group_drifts = new double[bounds]();
+  }
+
+  if (kernel == kmeans::kernel::gemm) {
+    worker_point_norms = new double[worker_amount]();
+    centroid_norms = new double[clusters]();
+    packed_centroids = new real[gemm::packed_size(clusters, dimension)]();
+
+    gemm::norms(worker_points, worker_point_norms, worker_amount, dimension);
+  }
+
+  if (sparse) {
+    centroid_norms = new double[clusters]();
+  }
+
+  if (batch_size > 0) {
+    worker_dist = new std::uniform_int_distribution<uint32_t>(
+        0, std::max(worker_amount, 1u) - 1);
+    batch_points = new uint32_t[worker_batch_size]();
+    batch_clusters = new uint16_t[worker_batch_size]();
+    batch_centroids = new double[clusters * dimension]();
+    batch_cluster_sizes = new uint32_t[clusters]();
+  }
 }
 
 data::~data()
 {
   if (rank == 0) {
-    delete[] points;
+    io::release(points);
+    io::release(initial_centroids);
+    csr::release(sparse_points);
     delete[] lowest_cost_point_clusters;
+    delete[] lowest_cost_centroids;
     delete[] centroid_point_indices;
     delete[] point_clusters_counts;
     delete[] point_clusters_displs;
@@ -56,9 +144,36 @@ data::~data()
   }
 
   delete[] worker_points;
+  csr::release(worker_sparse_points);
   delete[] worker_point_clusters;
   delete[] worker_centroids;
+  delete[] centroid_sums;
   delete[] worker_cluster_sizes;
+  accumulation::release(buffer);
+  delete[] running_centroid_sums;
+  delete[] running_cluster_sizes;
+  delete worker_mt;
+
+  delete[] worker_upper_bounds;
+  delete[] worker_lower_bounds;
+  delete[] previous_centroids;
+  delete[] centroid_drifts;
+  delete[] centroid_distances;
+  delete[] centroid_bounds;
+  delete[] centroid_groups;
+  delete[] group_centroids;
+  delete[] group_offsets;
+  delete[] group_drifts;
+
+  delete[] worker_point_norms;
+  delete[] centroid_norms;
+  delete[] packed_centroids;
+
+  delete worker_dist;
+  delete[] batch_points;
+  delete[] batch_clusters;
+  delete[] batch_centroids;
+  delete[] batch_cluster_sizes;
 }
 
 }
@@ -1,14 +1,23 @@
 #pragma once
 
+#include <kmeans/accumulation.hpp>
+#include <kmeans/assignment.hpp>
+#include <kmeans/csr.hpp>
 #include <kmeans/divide.hpp>
+#include <kmeans/kernel.hpp>
+#include <kmeans/real.hpp>
+#include <kmeans/seeding.hpp>
 
+#include <limits>
 #include <random>
 
 namespace kmeans {
 
 struct data {
-  double *points = nullptr;
+  real *points = nullptr;
   uint16_t *lowest_cost_point_clusters = nullptr;
+  real *lowest_cost_centroids = nullptr;
+  double lowest_cost = std::numeric_limits<double>::max();
   uint32_t *centroid_point_indices = nullptr;
   int *point_clusters_counts = nullptr;
   int *point_clusters_displs = nullptr;
@@ -16,27 +25,100 @@ struct data {
   std::uniform_int_distribution<uint32_t> *dist = nullptr;
   std::mt19937 *mt = nullptr;
 
+  // Only allocated for k-means|| seeding and mini-batch k-means which sample
+  // on every rank.
+  std::mt19937 *worker_mt = nullptr;
+
   const uint32_t amount;
   const uint16_t clusters;
   const uint32_t dimension;
 
-  double *worker_points;
+  real *worker_points;
   uint16_t *worker_point_clusters;
-  double *worker_centroids;
+  real *worker_centroids;
+  real *previous_centroids;
+  double *centroid_sums;
   uint32_t *worker_cluster_sizes;
+  accumulation::buffer buffer;
 
   const uint32_t worker_amount;
   const int processes;
   const int rank;
 
-  data(double *points,
+  // Sparse points (see csr.hpp) take the place of worker_points and points,
+  // which are null. Rank 0 only has all of them when it needs them to seed.
+  const bool sparse;
+  const csr::matrix sparse_points;
+  const csr::matrix worker_sparse_points;
+
+  // group() already sums the worker points of every cluster while it assigns
+  // them when fused (see accumulation.hpp), so centroids() only reduces the
+  // sums over the ranks.
+  const bool fused;
+
+  // Period of the incremental iterations (see accumulation::incremental()), 0
+  // unless the sums are fused.
+  const uint32_t incremental;
+
+  // Only allocated for incremental iterations, which keep the sums over the
+  // ranks here since the reduced sums only hold their change.
+  double *running_centroid_sums = nullptr;
+  uint32_t *running_cluster_sizes = nullptr;
+
+  const kmeans::assignment assignment;
+  const uint32_t bounds;
+  const kmeans::kernel kernel;
+  const kmeans::seeding seeding;
+  const uint32_t batch_size;
+  const uint32_t batch_iterations;
+  const bool batch_refine;
+
+  // Only allocated when the assignment algorithm keeps bounds.
+  double *worker_upper_bounds = nullptr;
+  double *worker_lower_bounds = nullptr;
+  double *centroid_drifts = nullptr;
+  double *centroid_distances = nullptr;
+  double *centroid_bounds = nullptr;
+  uint16_t *centroid_groups = nullptr;
+  uint16_t *group_centroids = nullptr;
+  uint32_t *group_offsets = nullptr;
+  double *group_drifts = nullptr;
+
+  // Only allocated for the gemm kernel (and the centroid norms for sparse
+  // points).
+  double *worker_point_norms = nullptr;
+  double *centroid_norms = nullptr;
+  real *packed_centroids = nullptr;
+
+  // Only loaded when seeding from given centroids.
+  real *initial_centroids = nullptr;
+
+  // Only allocated for mini-batch k-means. Every rank samples its share of
+  // each batch from its own worker points.
+  const uint32_t worker_batch_size;
+  std::uniform_int_distribution<uint32_t> *worker_dist = nullptr;
+  uint32_t *batch_points = nullptr;
+  uint16_t *batch_clusters = nullptr;
+  double *batch_centroids = nullptr;
+  uint32_t *batch_cluster_sizes = nullptr;
+
+  data(real *points,
+       const csr::matrix &sparse_points,
        uint32_t amount,
        uint16_t clusters,
        uint32_t dimension,
-       double *worker_points,
+       real *worker_points,
+       const csr::matrix &worker_sparse_points,
        uint32_t worker_amount,
        int processes,
-       int rank);
+       int rank,
+       kmeans::assignment assignment,
+       kmeans::kernel kernel,
+       kmeans::seeding seeding,
+       uint32_t batch_size,
+       uint32_t batch_iterations,
+       bool batch_refine,
+       uint32_t incremental);
 
   ~data();
 };
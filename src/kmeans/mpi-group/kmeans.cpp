@@ -1,25 +1,47 @@
 #include <kmeans/mpi-group/kmeans.hpp>
 
+#include <kmeans/accumulation.hpp>
+#include <kmeans/csr.hpp>
 #include <kmeans/distance.hpp>
+#include <kmeans/elkan.hpp>
+#include <kmeans/gemm.hpp>
+#include <kmeans/hamerly.hpp>
+#include <kmeans/lloyd.hpp>
+#include <kmeans/minibatch.hpp>
 #include <kmeans/random.hpp>
+#include <kmeans/scalable.hpp>
+#include <kmeans/yinyang.hpp>
 
 #include <kmeans/mpi-group/data.hpp>
 
 #include <mpi.h>
 
+#include <vector>
+
 namespace kmeans {
 
 static double cost(data *data)
 {
   double cost = 0;
 
+  if (data->sparse) {
+    gemm::norms(data->worker_centroids, data->centroid_norms, data->clusters,
+                data->dimension);
+  }
+
 #pragma omp parallel for reduction(+ : cost) schedule(static)
   for (uint32_t i = 0; i < data->worker_amount; i++) {
-    double *point = data->worker_points + i * data->dimension;
-    double *centroid = data->worker_centroids +
-                       data->worker_point_clusters[i] * data->dimension;
-
-    cost += distance(point, centroid, data->dimension);
+    uint16_t cluster = data->worker_point_clusters[i];
+    real *centroid = data->worker_centroids + cluster * data->dimension;
+
+    if (data->sparse) {
+      cost += csr::distance(data->worker_sparse_points, i, centroid,
+                            data->centroid_norms[cluster]);
+    } else {
+      real *point = data->worker_points +
+                    static_cast<size_t>(i) * data->dimension;
+      cost += distance(point, centroid, data->dimension);
+    }
   }
 
   MPI_Allreduce(MPI_IN_PLACE, &cost, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
@@ -27,77 +49,221 @@ static double cost(data *data)
   return cost;
 }
 
-static void centroids(data *data)
+// Moved adds the change of the sums to the sums of the previous iteration
+// (see accumulation::incremental()).
+static void centroids(data *data, bool moved)
 {
-  std::fill_n(data->worker_centroids, data->clusters * data->dimension, 0);
-  std::fill_n(data->worker_cluster_sizes, data->clusters, 0);
-
-  for (uint32_t i = 0; i < data->worker_amount; i++) {
-    uint16_t cluster = data->worker_point_clusters[i];
-    data->worker_cluster_sizes[cluster]++;
-
-    double *point = data->worker_points + i * data->dimension;
-    double *centroid = data->worker_centroids + cluster * data->dimension;
-
-    for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] += point[j];
-    }
+  std::copy_n(data->worker_centroids, data->clusters * data->dimension,
+              data->previous_centroids);
+
+  // Unless group() already summed the worker points (see data::fused).
+  if (!data->fused && data->sparse) {
+    accumulation::accumulate(&data->buffer, data->worker_sparse_points,
+                             data->worker_point_clusters, data->worker_amount,
+                             data->centroid_sums, data->worker_cluster_sizes,
+                             data->clusters, data->dimension);
+  } else if (!data->fused) {
+    accumulation::accumulate(&data->buffer, data->worker_points,
+                             data->worker_point_clusters, data->worker_amount,
+                             data->centroid_sums, data->worker_cluster_sizes,
+                             data->clusters, data->dimension);
   }
 
-  MPI_Allreduce(MPI_IN_PLACE, data->worker_centroids,
+  MPI_Allreduce(MPI_IN_PLACE, data->centroid_sums,
                 static_cast<int>(data->clusters * data->dimension), MPI_DOUBLE,
                 MPI_SUM, MPI_COMM_WORLD);
   MPI_Allreduce(MPI_IN_PLACE, data->worker_cluster_sizes, data->clusters,
                 MPI_INT32_T, MPI_SUM, MPI_COMM_WORLD);
 
-  for (uint16_t i = 0; i < data->clusters; i++) {
-    double *centroid = data->worker_centroids + i * data->dimension;
+  double *sums = data->centroid_sums;
+  uint32_t *sizes = data->worker_cluster_sizes;
 
-    for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] /= data->worker_cluster_sizes[i];
+  if (data->incremental > 0) {
+    for (uint32_t i = 0; i < data->clusters * data->dimension; i++) {
+      data->running_centroid_sums[i] =
+          moved ? data->running_centroid_sums[i] + sums[i] : sums[i];
     }
+
+    for (uint16_t i = 0; i < data->clusters; i++) {
+      data->running_cluster_sizes[i] =
+          moved ? data->running_cluster_sizes[i] + sizes[i] : sizes[i];
+    }
+
+    sums = data->running_centroid_sums;
+    sizes = data->running_cluster_sizes;
+  }
+
+  accumulation::average(sums, sizes, data->worker_centroids, data->clusters,
+                        data->dimension);
+
+  if (data->assignment != assignment::lloyd) {
+    drift(data->previous_centroids, data->worker_centroids,
+          data->centroid_drifts, data->clusters, data->dimension);
   }
 }
 
-static bool group(data *data)
+// Moved only sums the change of the sums with the points that changed cluster
+// (see accumulation::incremental()).
+static bool group(data *data, bool moved)
 {
-  bool point_clusters_equal = 1;
+  std::fill_n(data->centroid_sums, data->clusters * data->dimension, 0);
+  std::fill_n(data->worker_cluster_sizes, data->clusters, 0);
 
-#pragma omp parallel for reduction(min : point_clusters_equal) schedule(static)
-  for (uint32_t i = 0; i < data->worker_amount; i++) {
-    uint16_t previous_cluster = data->worker_point_clusters[i];
-    uint16_t cluster = previous_cluster;
+  if (data->fused) {
+    accumulation::reserve(&data->buffer, data->clusters, data->dimension);
+  }
+
+  if (data->sparse) {
+    gemm::norms(data->worker_centroids, data->centroid_norms, data->clusters,
+                data->dimension);
 
-    double *point = data->worker_points + i * data->dimension;
-    double *centroid = data->worker_centroids + cluster * data->dimension;
+    bool point_clusters_equal = true;
 
-    double lowest_distance = kmeans::distance(point, centroid, data->dimension);
+#pragma omp parallel reduction(min : point_clusters_equal)
+    {
+      accumulation::part part = {};
 
-    for (uint16_t j = 0; j < previous_cluster; j++) {
-      centroid = data->worker_centroids + j * data->dimension;
+      if (data->fused) {
+        part = accumulation::begin(&data->buffer, data->clusters,
+                                   data->dimension, moved);
+      }
 
-      double distance = kmeans::distance(point, centroid, data->dimension);
+#pragma omp for schedule(static)
+      for (uint32_t i = 0; i < data->worker_amount; i++) {
+        uint16_t previous_cluster = data->worker_point_clusters[i];
+        uint16_t cluster = csr::nearest(
+            data->worker_sparse_points, i, previous_cluster,
+            data->worker_centroids, data->centroid_norms, data->clusters,
+            data->dimension);
+
+        point_clusters_equal = point_clusters_equal &&
+                               previous_cluster == cluster;
+        data->worker_point_clusters[i] = cluster;
+
+        if (data->fused) {
+          accumulation::add(part, previous_cluster, cluster,
+                            data->worker_sparse_points, i, data->dimension);
+        }
+      }
 
-      if (distance < lowest_distance) {
-        cluster = j;
-        lowest_distance = distance;
+      if (data->fused) {
+        accumulation::end(&data->buffer, data->centroid_sums,
+                          data->worker_cluster_sizes, data->clusters,
+                          data->dimension);
       }
     }
 
-    for (uint16_t j = static_cast<uint16_t>(previous_cluster + 1);
-         j < data->clusters; j++) {
-      centroid = data->worker_centroids + j * data->dimension;
+    MPI_Allreduce(MPI_IN_PLACE, &point_clusters_equal, 1, MPI_CXX_BOOL,
+                  MPI_LAND, MPI_COMM_WORLD);
 
-      double distance = kmeans::distance(point, centroid, data->dimension);
+    return point_clusters_equal;
+  }
 
-      if (distance < lowest_distance) {
-        cluster = j;
-        lowest_distance = distance;
+  if (data->kernel == kernel::gemm) {
+    gemm::centroids(data->worker_centroids, data->centroid_norms,
+                    data->packed_centroids, data->clusters, data->dimension);
+
+    bool point_clusters_equal =
+        data->fused
+            ? gemm::assign(data->worker_points, data->worker_point_norms,
+                           data->worker_point_clusters, data->worker_amount,
+                           data->packed_centroids, data->centroid_norms,
+                           data->clusters, data->dimension, &data->buffer,
+                           data->centroid_sums, data->worker_cluster_sizes,
+                           moved)
+            : gemm::assign(data->worker_points, data->worker_point_norms,
+                           data->worker_point_clusters, data->worker_amount,
+                           data->packed_centroids, data->centroid_norms,
+                           data->clusters, data->dimension);
+
+    MPI_Allreduce(MPI_IN_PLACE, &point_clusters_equal, 1, MPI_CXX_BOOL,
+                  MPI_LAND, MPI_COMM_WORLD);
+
+    return point_clusters_equal;
+  }
+
+  if (data->assignment == assignment::elkan) {
+    elkan::centroids(data->worker_centroids, data->centroid_distances,
+                     data->centroid_bounds, data->clusters, data->dimension);
+  }
+
+  hamerly::drift drift = {};
+
+  if (data->assignment == assignment::hamerly) {
+    hamerly::centroids(data->worker_centroids, data->centroid_bounds,
+                       data->clusters, data->dimension);
+    drift = hamerly::drifts(data->centroid_drifts, data->clusters);
+  }
+
+  if (data->assignment == assignment::yinyang) {
+    yinyang::drifts(data->centroid_drifts, data->centroid_groups,
+                    data->group_drifts, data->clusters, data->bounds);
+  }
+
+  bool point_clusters_equal = 1;
+
+#pragma omp parallel reduction(min : point_clusters_equal)
+  {
+    accumulation::part part = {};
+
+    if (data->fused) {
+      part = accumulation::begin(&data->buffer, data->clusters,
+                                 data->dimension, moved);
+    }
+
+#pragma omp for schedule(static)
+    for (uint32_t i = 0; i < data->worker_amount; i++) {
+      uint16_t previous_cluster = data->worker_point_clusters[i];
+      uint16_t cluster = previous_cluster;
+
+      real *point = data->worker_points +
+                    static_cast<size_t>(i) * data->dimension;
+      double *lower_bounds = data->worker_lower_bounds +
+                             static_cast<size_t>(i) * data->bounds;
+
+      switch (data->assignment) {
+        case assignment::lloyd:
+          cluster = lloyd::nearest(point, cluster, data->worker_centroids,
+                                   data->clusters, data->dimension);
+          break;
+        case assignment::elkan:
+          cluster = elkan::nearest(point, cluster, data->worker_centroids,
+                                   data->centroid_distances,
+                                   data->centroid_bounds, data->centroid_drifts,
+                                   data->worker_upper_bounds + i, lower_bounds,
+                                   data->clusters, data->dimension);
+          break;
+        case assignment::hamerly:
+          cluster = hamerly::nearest(
+              point, cluster, data->worker_centroids, data->centroid_bounds,
+              data->centroid_drifts, drift, data->worker_upper_bounds + i,
+              lower_bounds, data->clusters, data->dimension);
+          break;
+        case assignment::yinyang:
+          cluster = yinyang::nearest(
+              point, cluster, data->worker_centroids, data->centroid_groups,
+              data->group_centroids, data->group_offsets,
+              data->centroid_drifts, data->group_drifts,
+              data->worker_upper_bounds + i, lower_bounds, data->bounds,
+              data->dimension);
+          break;
+      }
+
+      point_clusters_equal = point_clusters_equal &&
+                             previous_cluster == cluster;
+      data->worker_point_clusters[i] = cluster;
+
+      if (data->fused) {
+        accumulation::add(part, previous_cluster, cluster, point,
+                          data->dimension);
       }
     }
 
-    point_clusters_equal = point_clusters_equal && previous_cluster == cluster;
-    data->worker_point_clusters[i] = cluster;
+    if (data->fused) {
+      accumulation::end(&data->buffer, data->centroid_sums,
+                        data->worker_cluster_sizes, data->clusters,
+                        data->dimension);
+    }
   }
 
   MPI_Allreduce(MPI_IN_PLACE, &point_clusters_equal, 1, MPI_INT32_T, MPI_MIN,
@@ -106,35 +272,238 @@ static bool group(data *data)
   return point_clusters_equal;
 }
 
-static void run(data *data)
+// k-means|| where every rank samples candidates from its own worker points.
+// The candidates are gathered on every rank after each round and rank 0
+// reduces them to the initial centroids.
+static void seed_scalable(data *data)
 {
+  auto point_distances = std::vector<double>(
+      data->worker_amount, std::numeric_limits<double>::max());
+  auto point_candidates = std::vector<uint32_t>(data->worker_amount);
+  auto candidates = std::vector<real>(data->dimension);
+
+  uint32_t first = 0;
+
   if (data->rank == 0) {
-    random::centroids(data->points, data->worker_centroids,
-                      data->centroid_point_indices, data->clusters,
-                      data->dimension, data->dist, data->mt);
+    first = (*data->dist)(*data->mt);
+  }
+
+  MPI_Bcast(&first, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+  int owner = 0;
+
+  while (owner + 1 < data->processes &&
+         divide::displ(data->amount, data->processes, owner + 1) <= first) {
+    owner++;
   }
 
+  if (data->rank == owner) {
+    uint32_t displ = divide::displ(data->amount, data->processes, owner);
+    real *point = data->worker_points +
+                  static_cast<size_t>(first - displ) * data->dimension;
+    std::copy_n(point, data->dimension, candidates.begin());
+  }
+
+  MPI_Bcast(candidates.data(), static_cast<int>(data->dimension),
+            KMEANS_MPI_REAL, owner, MPI_COMM_WORLD);
+
+  double total = scalable::update(data->worker_points, point_distances.data(),
+                                  point_candidates.data(), data->worker_amount,
+                                  candidates.data(), 0, 1, data->dimension);
+  MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  auto counts = std::vector<int>(static_cast<uint32_t>(data->processes));
+  auto displs = std::vector<int>(static_cast<uint32_t>(data->processes));
+
+  uint32_t candidate_amount = 1;
+  double factor = static_cast<double>(scalable::oversampling) * data->clusters;
+
+  for (uint32_t round = 0;
+       round < scalable::rounds ||
+       (candidate_amount < data->clusters && total > 0);
+       round++) {
+    auto sampled = std::vector<real>();
+    scalable::sample(data->worker_points, point_distances.data(),
+                     data->worker_amount, data->dimension, factor, total,
+                     data->worker_mt, &sampled);
+
+    int count = static_cast<int>(sampled.size());
+    MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT,
+                  MPI_COMM_WORLD);
+
+    int size = 0;
+
+    for (uint32_t i = 0; i < counts.size(); i++) {
+      displs[i] = size;
+      size += counts[i];
+    }
+
+    candidates.resize(candidates.size() + static_cast<uint32_t>(size));
+
+    MPI_Allgatherv(sampled.data(), count, KMEANS_MPI_REAL,
+                   candidates.data() + candidate_amount * data->dimension,
+                   counts.data(), displs.data(), KMEANS_MPI_REAL,
+                   MPI_COMM_WORLD);
+
+    uint32_t first_candidate = candidate_amount;
+    candidate_amount = static_cast<uint32_t>(candidates.size() /
+                                             data->dimension);
+
+    total = scalable::update(data->worker_points, point_distances.data(),
+                             point_candidates.data(), data->worker_amount,
+                             candidates.data(), first_candidate,
+                             candidate_amount, data->dimension);
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_DOUBLE, MPI_SUM,
+                  MPI_COMM_WORLD);
+  }
+
+  auto weights = std::vector<uint32_t>(candidate_amount);
+  scalable::weigh(point_candidates.data(), data->worker_amount,
+                  weights.data());
+
+  MPI_Reduce(data->rank == 0 ? MPI_IN_PLACE : weights.data(), weights.data(),
+             static_cast<int>(candidate_amount), MPI_UINT32_T, MPI_SUM, 0,
+             MPI_COMM_WORLD);
+
+  if (data->rank == 0) {
+    scalable::reduce(candidates.data(), weights.data(), candidate_amount,
+                     data->worker_centroids, data->clusters, data->dimension,
+                     data->mt);
+  }
+}
+
+// Picks the initial centroids of a repetition in worker_centroids of rank 0.
+static void seed(data *data)
+{
+  switch (data->seeding) {
+    case seeding::random:
+      if (data->rank == 0 && data->sparse) {
+        csr::centroids(data->sparse_points, data->worker_centroids,
+                       data->centroid_point_indices, data->clusters,
+                       data->dimension, data->dist, data->mt);
+      } else if (data->rank == 0) {
+        random::centroids(data->points, data->worker_centroids,
+                          data->centroid_point_indices, data->clusters,
+                          data->dimension, data->dist, data->mt);
+      }
+      break;
+    case seeding::kmeanspp:
+      if (data->rank == 0 && data->sparse) {
+        csr::kmeanspp(data->sparse_points, data->worker_centroids,
+                      data->centroid_point_indices, data->amount,
+                      data->clusters, data->dimension, data->dist, data->mt);
+      } else if (data->rank == 0) {
+        random::kmeanspp(data->points, data->worker_centroids,
+                         data->centroid_point_indices, data->amount,
+                         data->clusters, data->dimension, data->dist,
+                         data->mt);
+      }
+      break;
+    case seeding::scalable:
+      seed_scalable(data);
+      break;
+    case seeding::given:
+      if (data->rank == 0) {
+        std::copy_n(data->initial_centroids, data->clusters * data->dimension,
+                    data->worker_centroids);
+      }
+      break;
+  }
+}
+
+// Every rank assigns and sums its share of each batch after which the sums are
+// reduced so every rank moves the centroids the same way.
+static void batches(data *data)
+{
+  std::fill_n(data->worker_cluster_sizes, data->clusters, 0);
+
+  // Ranks without points still take part in the reductions.
+  uint32_t worker_batch_size = data->worker_amount > 0
+                                   ? data->worker_batch_size
+                                   : 0;
+
+  for (uint32_t i = 0; i < data->batch_iterations; i++) {
+    minibatch::sample(data->batch_points, worker_batch_size, data->worker_dist,
+                      data->worker_mt);
+    minibatch::assign(data->worker_points, data->batch_points,
+                      data->batch_clusters, worker_batch_size,
+                      data->worker_centroids, data->clusters, data->dimension);
+    minibatch::accumulate(data->worker_points, data->batch_points,
+                          data->batch_clusters, worker_batch_size,
+                          data->batch_centroids, data->batch_cluster_sizes,
+                          data->clusters, data->dimension);
+
+    MPI_Allreduce(MPI_IN_PLACE, data->batch_centroids,
+                  static_cast<int>(data->clusters * data->dimension),
+                  MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, data->batch_cluster_sizes, data->clusters,
+                  MPI_UINT32_T, MPI_SUM, MPI_COMM_WORLD);
+
+    minibatch::update(data->worker_centroids, data->worker_cluster_sizes,
+                      data->batch_centroids, data->batch_cluster_sizes,
+                      data->clusters, data->dimension);
+  }
+}
+
+static void run(data *data)
+{
+  seed(data);
+
   MPI_Bcast(data->worker_centroids,
-            static_cast<int>(data->clusters * data->dimension), MPI_DOUBLE, 0,
-            MPI_COMM_WORLD);
+            static_cast<int>(data->clusters * data->dimension),
+            KMEANS_MPI_REAL, 0, MPI_COMM_WORLD);
+
+  if (data->batch_size > 0) {
+    batches(data);
+  }
 
   std::fill_n(data->worker_point_clusters, data->worker_amount, 0);
 
-  while (!group(data)) {
-    centroids(data);
+  if (data->assignment != assignment::lloyd) {
+    reset(data->worker_upper_bounds, data->worker_lower_bounds,
+          data->worker_amount, data->bounds);
+    std::fill_n(data->centroid_drifts, data->clusters, 0);
+  }
+
+  if (data->assignment == assignment::yinyang) {
+    yinyang::partition(data->worker_centroids, data->centroid_groups,
+                       data->group_centroids, data->group_offsets,
+                       data->clusters, data->bounds, data->dimension);
+  }
+
+  // Mini-batch k-means only needs a single pass over every point to assign
+  // each point to its nearest centroid unless asked to refine the centroids.
+  if (data->batch_size > 0 && !data->batch_refine) {
+    group(data, false);
+    return;
+  }
+
+  for (uint32_t iteration = 0;; iteration++) {
+    bool moved = accumulation::incremental(data->incremental, iteration);
+
+    if (group(data, moved)) {
+      break;
+    }
+
+    centroids(data, moved);
   }
 }
 
 void run(data *data, uint32_t repetitions)
 {
-  double lowest_cost = std::numeric_limits<double>::max();
-
   for (uint32_t i = 0; i < repetitions; i++) {
     run(data);
 
     double cost = kmeans::cost(data);
-    if (cost < lowest_cost) {
-      lowest_cost = cost;
+    if (cost < data->lowest_cost) {
+      data->lowest_cost = cost;
+
+      // Every rank has the same centroids.
+      if (data->rank == 0) {
+        std::copy_n(data->worker_centroids, data->clusters * data->dimension,
+                    data->lowest_cost_centroids);
+      }
+
       int worker_amount = static_cast<int>(data->worker_amount);
       MPI_Gatherv(data->worker_point_clusters, worker_amount, MPI_INT16_T,
                   data->lowest_cost_point_clusters, data->point_clusters_counts,
@@ -1,81 +1,537 @@
 #include <kmeans/args.hpp>
+#include <kmeans/binary.hpp>
+#include <kmeans/cache.hpp>
+#include <kmeans/CSVReader.hpp>
 #include <kmeans/divide.hpp>
 #include <kmeans/io.hpp>
 
 #include <kmeans/mpi-group/data.hpp>
 #include <kmeans/mpi-group/kmeans.hpp>
 
-#include <mpi.h>
 #include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
 
-kmeans::data initialize(const kmeans::args &args)
+// Checks that the amount points of the given dimension that are sent in one
+// collective can be counted with MPI's int counts and displacements.
+static void check_count(uint64_t amount,
+                        uint64_t dimension,
+                        const std::string &path)
 {
-  int processes;
-  MPI_Comm_size(MPI_COMM_WORLD, &processes);
-  int rank;
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (amount * dimension > INT_MAX) {
+    throw std::runtime_error("Too many values in '" + path +
+                             "' for MPI's int counts");
+  }
+}
 
-  double *points;
-  int *point_counts;
-  int *point_displs;
+// Reads length bytes at offset in pieces small enough for MPI's int counts.
+static void read_at(MPI_File file, MPI_Offset offset, char *bytes,
+                    size_t length, const std::string &path)
+{
+  const size_t piece = size_t(1) << 30;
 
-  uint32_t amount;
-  uint32_t dimension;
-  uint16_t clusters;
+  for (size_t done = 0; done < length; done += piece) {
+    int count = static_cast<int>(std::min(piece, length - done));
+    MPI_Status status;
 
-  if (rank == 0) {
-    std::vector<std::vector<double>> points2D = kmeans::io::input(
-        args.input_csv_path);
+    if (MPI_File_read_at(file, offset + static_cast<MPI_Offset>(done),
+                         bytes + done, count, MPI_BYTE,
+                         &status) != MPI_SUCCESS) {
+      throw std::runtime_error("Can't read '" + path + "'");
+    }
+  }
+}
 
-    amount = static_cast<uint32_t>(points2D.size());
-    clusters = args.clusters;
-    dimension = static_cast<uint32_t>(points2D[0].size());
+// Writes length bytes at offset in pieces small enough for MPI's int counts.
+// Returns false if a piece can't be written.
+static bool write_at(MPI_File file, MPI_Offset offset, const char *bytes,
+                     size_t length)
+{
+  const size_t piece = size_t(1) << 30;
 
-    points = new double[amount * dimension]();
+  for (size_t done = 0; done < length; done += piece) {
+    int count = static_cast<int>(std::min(piece, length - done));
+    MPI_Status status;
 
-    for (uint32_t i = 0; i < amount; i++) {
-      double *point = points + i * dimension;
-      double *point2D = &points2D[i].front();
+    if (MPI_File_write_at(file, offset + static_cast<MPI_Offset>(done),
+                          bytes + done, count, MPI_BYTE,
+                          &status) != MPI_SUCCESS) {
+      return false;
+    }
+  }
 
-      std::copy_n(point2D, dimension, point);
+  return true;
+}
+
+// Reads the share of the points of a binary point file that belongs to rank
+// with MPI-IO.
+static kmeans::real *read_binary(const std::string &path,
+                                 int processes,
+                                 int rank,
+                                 uint32_t *amount,
+                                 uint32_t *dimension)
+{
+  kmeans::binary::header header = kmeans::binary::inspect(path);
+
+  *amount = static_cast<uint32_t>(header.amount);
+  *dimension = static_cast<uint32_t>(header.dimension);
+
+  uint32_t worker_displ = kmeans::divide::displ(*amount, processes, rank);
+  uint32_t worker_amount = kmeans::divide::amount(*amount, processes, rank);
+
+  size_t value_size = kmeans::binary::size(header.dtype);
+  size_t row_size = header.stride * value_size;
+  size_t length = worker_amount == 0 ? 0
+                                     : (worker_amount - 1) * row_size +
+                                           *dimension * value_size;
+  auto offset = static_cast<MPI_Offset>(header.offset +
+                                        worker_displ * row_size);
+
+  MPI_File file;
+
+  if (MPI_File_open(MPI_COMM_SELF, path.c_str(), MPI_MODE_RDONLY,
+                    MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+    throw std::runtime_error("Can't open '" + path + "'");
+  }
+
+  auto worker_points =
+      new kmeans::real[static_cast<size_t>(worker_amount) * *dimension];
+
+  if (kmeans::binary::native(header)) {
+    read_at(file, offset, reinterpret_cast<char *>(worker_points), length,
+            path);
+  } else {
+    auto bytes = std::vector<char>(length);
+    read_at(file, offset, bytes.data(), length, path);
+    kmeans::binary::convert(bytes.data(), header, worker_amount,
+                            worker_points);
+  }
+
+  MPI_File_close(&file);
+
+  return worker_points;
+}
+
+// Counts and displacements of the points every rank sends to and receives from
+// each rank so the points in the parts of the input that the ranks parsed end
+// up in the shares of the ranks.
+struct exchange {
+  std::vector<int> send_counts;
+  std::vector<int> send_displs;
+  std::vector<int> receive_counts;
+  std::vector<int> receive_displs;
+};
+
+// Plans the exchange of the part_amount points that rank parsed and stores the
+// amount of points of all parts in amount.
+static exchange plan(uint32_t part_amount,
+                     int processes,
+                     int rank,
+                     uint32_t *amount)
+{
+  auto part_amounts = std::vector<uint32_t>(static_cast<uint32_t>(processes));
+  MPI_Allgather(&part_amount, 1, MPI_UINT32_T, part_amounts.data(), 1,
+                MPI_UINT32_T, MPI_COMM_WORLD);
+
+  auto part_displs = std::vector<uint32_t>(part_amounts.size());
+  *amount = 0;
+
+  for (uint32_t i = 0; i < part_amounts.size(); i++) {
+    part_displs[i] = *amount;
+    *amount += part_amounts[i];
+  }
+
+  uint32_t part_displ = part_displs[static_cast<uint32_t>(rank)];
+  uint32_t worker_displ = kmeans::divide::displ(*amount, processes, rank);
+  uint32_t worker_amount = kmeans::divide::amount(*amount, processes, rank);
+
+  exchange exchange;
+  exchange.send_counts.resize(part_amounts.size());
+  exchange.send_displs.resize(part_amounts.size());
+  exchange.receive_counts.resize(part_amounts.size());
+  exchange.receive_displs.resize(part_amounts.size());
+
+  // Every rank sends the overlap of its part with the share of each rank and
+  // receives the overlap of the part of each rank with its share.
+  for (int i = 0; i < processes; i++) {
+    uint32_t ui = static_cast<uint32_t>(i);
+    uint32_t displ = kmeans::divide::displ(*amount, processes, i);
+    uint32_t first = std::max(part_displ, displ);
+    uint32_t last = std::min(
+        part_displ + part_amount,
+        displ + kmeans::divide::amount(*amount, processes, i));
+
+    exchange.send_counts[ui] = static_cast<int>(first < last ? last - first
+                                                             : 0);
+    exchange.send_displs[ui] = static_cast<int>(
+        first < last ? first - part_displ : 0);
+
+    first = std::max(part_displs[ui], worker_displ);
+    last = std::min(part_displs[ui] + part_amounts[ui],
+                    worker_displ + worker_amount);
+
+    exchange.receive_counts[ui] = static_cast<int>(first < last ? last - first
+                                                                : 0);
+    exchange.receive_displs[ui] = static_cast<int>(
+        first < last ? first - worker_displ : 0);
+  }
+
+  return exchange;
+}
+
+// Parses the lines that start in the rank-th part of the bytes of a CSV file
+// after which the parsed points are exchanged so every rank ends up with its
+// share of the points.
+static kmeans::real *read_csv(const std::string &path,
+                              int processes,
+                              int rank,
+                              uint32_t *amount,
+                              uint32_t *dimension)
+{
+  uint32_t part_amount;
+  kmeans::real *part_points = kmeans::CSVReader(path).read(
+      rank, processes, &part_amount, dimension);
+
+  exchange exchange = plan(part_amount, processes, rank, amount);
+  uint32_t worker_amount = kmeans::divide::amount(*amount, processes, rank);
+
+  check_count(part_amount, *dimension, path);
+  check_count(worker_amount, *dimension, path);
+
+  for (int i = 0; i < processes; i++) {
+    uint32_t ui = static_cast<uint32_t>(i);
+    int values = static_cast<int>(*dimension);
+
+    exchange.send_counts[ui] *= values;
+    exchange.send_displs[ui] *= values;
+    exchange.receive_counts[ui] *= values;
+    exchange.receive_displs[ui] *= values;
+  }
+
+  auto worker_points =
+      new kmeans::real[static_cast<size_t>(worker_amount) * *dimension];
+
+  MPI_Alltoallv(part_points, exchange.send_counts.data(),
+                exchange.send_displs.data(), KMEANS_MPI_REAL, worker_points,
+                exchange.receive_counts.data(),
+                exchange.receive_displs.data(), KMEANS_MPI_REAL,
+                MPI_COMM_WORLD);
+
+  delete[] part_points;
+
+  return worker_points;
+}
+
+// Like read_csv() for sparse points. The amounts of nonzero values of the
+// points are exchanged first, which tell every rank how many indices and
+// values it receives from each rank.
+static kmeans::csr::matrix read_sparse(const std::string &path,
+                                       int processes,
+                                       int rank,
+                                       uint32_t *amount,
+                                       uint32_t *dimension)
+{
+  uint32_t part_amount;
+  kmeans::csr::matrix part_points = kmeans::CSVReader(path).read_sparse(
+      rank, processes, &part_amount, dimension);
+
+  MPI_Allreduce(MPI_IN_PLACE, dimension, 1, MPI_UINT32_T, MPI_MAX,
+                MPI_COMM_WORLD);
+
+  exchange exchange = plan(part_amount, processes, rank, amount);
+  uint32_t worker_amount = kmeans::divide::amount(*amount, processes, rank);
+
+  check_count(part_amount, *dimension, path);
+  check_count(worker_amount, *dimension, path);
+
+  if (*amount == 0) {
+    kmeans::csr::release(part_points);
+    throw std::runtime_error("No points in '" + path + "'");
+  }
+
+  auto part_lengths = std::vector<uint32_t>(part_amount);
+  auto worker_lengths = std::vector<uint32_t>(worker_amount);
+
+  for (uint32_t i = 0; i < part_amount; i++) {
+    part_lengths[i] = static_cast<uint32_t>(part_points.offsets[i + 1] -
+                                            part_points.offsets[i]);
+  }
+
+  MPI_Alltoallv(part_lengths.data(), exchange.send_counts.data(),
+                exchange.send_displs.data(), MPI_UINT32_T,
+                worker_lengths.data(), exchange.receive_counts.data(),
+                exchange.receive_displs.data(), MPI_UINT32_T, MPI_COMM_WORLD);
+
+  auto worker_offsets = std::vector<uint64_t>(worker_amount + 1);
+
+  for (uint32_t i = 0; i < worker_amount; i++) {
+    worker_offsets[i + 1] = worker_offsets[i] + worker_lengths[i];
+  }
+
+  kmeans::csr::matrix worker_points = kmeans::csr::allocate(
+      worker_amount, worker_offsets[worker_amount]);
+  std::copy(worker_offsets.begin(), worker_offsets.end(),
+            worker_points.offsets);
+
+  // The same exchange in nonzero values instead of points.
+  for (int i = 0; i < processes; i++) {
+    uint32_t ui = static_cast<uint32_t>(i);
+    auto send_first = static_cast<uint32_t>(exchange.send_displs[ui]);
+    auto send_last = send_first +
+                     static_cast<uint32_t>(exchange.send_counts[ui]);
+    auto receive_first = static_cast<uint32_t>(exchange.receive_displs[ui]);
+    auto receive_last = receive_first +
+                        static_cast<uint32_t>(exchange.receive_counts[ui]);
+
+    exchange.send_counts[ui] = static_cast<int>(
+        part_points.offsets[send_last] - part_points.offsets[send_first]);
+    exchange.send_displs[ui] = static_cast<int>(
+        part_points.offsets[send_first]);
+    exchange.receive_counts[ui] = static_cast<int>(
+        worker_offsets[receive_last] - worker_offsets[receive_first]);
+    exchange.receive_displs[ui] = static_cast<int>(
+        worker_offsets[receive_first]);
+  }
+
+  MPI_Alltoallv(part_points.indices, exchange.send_counts.data(),
+                exchange.send_displs.data(), MPI_UINT32_T,
+                worker_points.indices, exchange.receive_counts.data(),
+                exchange.receive_displs.data(), MPI_UINT32_T, MPI_COMM_WORLD);
+  MPI_Alltoallv(part_points.values, exchange.send_counts.data(),
+                exchange.send_displs.data(), KMEANS_MPI_REAL,
+                worker_points.values, exchange.receive_counts.data(),
+                exchange.receive_displs.data(), KMEANS_MPI_REAL,
+                MPI_COMM_WORLD);
+
+  kmeans::csr::release(part_points);
+  kmeans::csr::norms(worker_points, worker_amount);
+
+  return worker_points;
+}
+
+// Gathers the sparse points of every rank on rank 0, in the same way as their
+// amounts of nonzero values, indices and values.
+static kmeans::csr::matrix gather_sparse(
+    const kmeans::csr::matrix &worker_points,
+    uint32_t amount,
+    int processes,
+    int rank)
+{
+  uint32_t worker_amount = kmeans::divide::amount(amount, processes, rank);
+  auto worker_lengths = std::vector<uint32_t>(worker_amount);
+
+  for (uint32_t i = 0; i < worker_amount; i++) {
+    worker_lengths[i] = static_cast<uint32_t>(worker_points.offsets[i + 1] -
+                                              worker_points.offsets[i]);
+  }
+
+  auto counts = std::vector<int>(static_cast<uint32_t>(processes));
+  auto displs = std::vector<int>(static_cast<uint32_t>(processes));
+  auto lengths = std::vector<uint32_t>(rank == 0 ? amount : 0);
+
+  for (int i = 0; i < processes; i++) {
+    uint32_t ui = static_cast<uint32_t>(i);
+    counts[ui] = static_cast<int>(kmeans::divide::amount(amount, processes, i));
+    displs[ui] = static_cast<int>(kmeans::divide::displ(amount, processes, i));
+  }
+
+  MPI_Gatherv(worker_lengths.data(), static_cast<int>(worker_amount),
+              MPI_UINT32_T, lengths.data(), counts.data(), displs.data(),
+              MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+  kmeans::csr::matrix points;
+
+  if (rank == 0) {
+    uint64_t nonzeros = 0;
+
+    for (uint32_t length : lengths) {
+      nonzeros += length;
     }
 
-    point_counts = new int[static_cast<uint32_t>(processes)];
-    point_displs = new int[static_cast<uint32_t>(processes)];
+    points = kmeans::csr::allocate(amount, nonzeros);
+
+    for (uint32_t i = 0; i < amount; i++) {
+      points.offsets[i + 1] = points.offsets[i] + lengths[i];
+    }
 
     for (int i = 0; i < processes; i++) {
-      point_counts[i] = static_cast<int>(
-          kmeans::divide::amount(amount, processes, i) * dimension);
-      point_displs[i] = static_cast<int>(
-          kmeans::divide::displ(amount, processes, i) * dimension);
+      uint32_t ui = static_cast<uint32_t>(i);
+      auto first = static_cast<uint32_t>(displs[ui]);
+      auto last = first + static_cast<uint32_t>(counts[ui]);
+
+      counts[ui] = static_cast<int>(points.offsets[last] -
+                                    points.offsets[first]);
+      displs[ui] = static_cast<int>(points.offsets[first]);
     }
+  }
+
+  auto worker_nonzeros = static_cast<int>(worker_points.offsets[worker_amount] -
+                                          worker_points.offsets[0]);
+
+  MPI_Gatherv(worker_points.indices, worker_nonzeros, MPI_UINT32_T,
+              points.indices, counts.data(), displs.data(), MPI_UINT32_T, 0,
+              MPI_COMM_WORLD);
+  MPI_Gatherv(worker_points.values, worker_nonzeros, KMEANS_MPI_REAL,
+              points.values, counts.data(), displs.data(), KMEANS_MPI_REAL, 0,
+              MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    kmeans::csr::norms(points, amount);
+  }
+
+  return points;
+}
+
+// Writes the cache of the CSV file at path (see cache.hpp) with MPI-IO, every
+// rank its own share of the points after rank 0 wrote the header and the key.
+// Like cache::store(), the cache is skipped when it can't be written.
+static void store_cache(const std::string &path,
+                        kmeans::real *worker_points,
+                        uint32_t amount,
+                        uint32_t dimension,
+                        int processes,
+                        int rank)
+{
+  long id = getpid();
+  MPI_Bcast(&id, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+
+  std::string written = kmeans::cache::temporary(path, id);
+  MPI_File file;
+
+  if (MPI_File_open(MPI_COMM_WORLD, written.c_str(),
+                    MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                    &file) != MPI_SUCCESS) {
+    return;
+  }
 
-    MPI_Bcast(&amount, 1, MPI_INT32_T, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&clusters, 1, MPI_INT16_T, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&dimension, 1, MPI_INT32_T, 0, MPI_COMM_WORLD);
+  bool success = true;
+
+  if (rank == 0) {
+    kmeans::binary::header header = kmeans::binary::describe(
+        amount, dimension, kmeans::binary::real_dtype);
+    kmeans::cache::key key = kmeans::cache::stamp(path);
+
+    success = write_at(file, 0, reinterpret_cast<const char *>(&header),
+                       sizeof(header)) &&
+              write_at(file, kmeans::cache::key_offset,
+                       reinterpret_cast<const char *>(&key), sizeof(key));
+  }
+
+  size_t row_size = dimension * sizeof(kmeans::real);
+  uint32_t worker_displ = kmeans::divide::displ(amount, processes, rank);
+  uint32_t worker_amount = kmeans::divide::amount(amount, processes, rank);
+
+  success = write_at(file,
+                     static_cast<MPI_Offset>(kmeans::binary::alignment +
+                                             worker_displ * row_size),
+                     reinterpret_cast<const char *>(worker_points),
+                     worker_amount * row_size) &&
+            success;
+
+  MPI_File_close(&file);
+  MPI_Allreduce(MPI_IN_PLACE, &success, 1, MPI_CXX_BOOL, MPI_LAND,
+                MPI_COMM_WORLD);
+
+  // Renaming only makes complete caches visible to other processes.
+  if (rank == 0 && (!success || std::rename(written.c_str(),
+                                            kmeans::cache::path(path)
+                                                .c_str()) != 0)) {
+    std::remove(written.c_str());
+  }
+}
+
+// Every rank reads its own share of the input. Rank 0 only gathers all points
+// when it needs them to seed.
+kmeans::data initialize(const kmeans::args &args)
+{
+  if (!args.out_of_core_directory.empty()) {
+    throw kmeans::invalid_argument("--out-of-core",
+                                   args.out_of_core_directory +
+                                       " (requires seq or omp-group)");
+  }
+
+  int processes;
+  MPI_Comm_size(MPI_COMM_WORLD, &processes);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  uint32_t amount;
+  uint32_t dimension;
+  kmeans::real *worker_points = nullptr;
+  kmeans::csr::matrix worker_sparse_points;
+
+  const std::string &path = args.input_csv_path;
+  bool caching = !args.sparse && kmeans::cache::enabled() &&
+                 !kmeans::binary::detect(path);
+
+  // Rank 0 decides whether the cache is used so every rank reads the same way.
+  bool cached = caching && rank == 0 && kmeans::cache::valid(path);
+  MPI_Bcast(&cached, 1, MPI_CXX_BOOL, 0, MPI_COMM_WORLD);
+
+  if (args.sparse) {
+    worker_sparse_points = read_sparse(path, processes, rank, &amount,
+                                       &dimension);
+  } else if (cached) {
+    worker_points = read_binary(kmeans::cache::path(path), processes, rank,
+                                &amount, &dimension);
+  } else if (kmeans::binary::detect(path)) {
+    worker_points = read_binary(path, processes, rank, &amount, &dimension);
   } else {
-    points = nullptr;
-    point_counts = nullptr;
-    point_displs = nullptr;
+    worker_points = read_csv(path, processes, rank, &amount, &dimension);
 
-    MPI_Bcast(&amount, 1, MPI_INT32_T, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&clusters, 1, MPI_INT16_T, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&dimension, 1, MPI_INT32_T, 0, MPI_COMM_WORLD);
+    if (caching) {
+      store_cache(path, worker_points, amount, dimension, processes, rank);
+    }
   }
 
   uint32_t worker_amount = kmeans::divide::amount(amount, processes, rank);
+  kmeans::real *points = nullptr;
+  kmeans::csr::matrix sparse_points;
 
-  double *worker_points = new double[worker_amount * dimension]();
-  int size = static_cast<int>(worker_amount * dimension);
+  bool gather = args.seeding == kmeans::seeding::random ||
+                args.seeding == kmeans::seeding::kmeanspp;
 
-  MPI_Scatterv(points, point_counts, point_displs, MPI_DOUBLE, worker_points,
-               size, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  if (gather && args.sparse) {
+    sparse_points = gather_sparse(worker_sparse_points, amount, processes,
+                                  rank);
+  } else if (gather) {
+    check_count(amount, dimension, path);
 
-  delete[] point_counts;
-  delete[] point_displs;
+    int *point_counts = nullptr;
+    int *point_displs = nullptr;
 
-  return kmeans::data(points, amount, clusters, dimension, worker_points,
-                      worker_amount, processes, rank);
+    if (rank == 0) {
+      points = new kmeans::real[static_cast<size_t>(amount) * dimension];
+      point_counts = new int[static_cast<uint32_t>(processes)];
+      point_displs = new int[static_cast<uint32_t>(processes)];
+
+      for (int i = 0; i < processes; i++) {
+        point_counts[i] = static_cast<int>(
+            kmeans::divide::amount(amount, processes, i) * dimension);
+        point_displs[i] = static_cast<int>(
+            kmeans::divide::displ(amount, processes, i) * dimension);
+      }
+    }
+
+    int size = static_cast<int>(worker_amount * dimension);
+
+    MPI_Gatherv(worker_points, size, KMEANS_MPI_REAL, points, point_counts,
+                point_displs, KMEANS_MPI_REAL, 0, MPI_COMM_WORLD);
+
+    delete[] point_counts;
+    delete[] point_displs;
+  }
+
+  return kmeans::data(points, sparse_points, amount, args.clusters, dimension,
+                      worker_points, worker_sparse_points, worker_amount,
+                      processes, rank, args.assignment, args.kernel,
+                      args.seeding, args.batch_size, args.batch_iterations,
+                      args.batch_refine, args.incremental);
 }
 
 int main(int argc, char *argv[])
@@ -85,6 +541,12 @@ int main(int argc, char *argv[])
   kmeans::args args = kmeans::args::parse(argc, argv);
   kmeans::data data = initialize(args);
 
+  // Only rank 0 seeds, the centroids are broadcast to the other ranks.
+  if (data.rank == 0 && args.seeding == kmeans::seeding::given) {
+    data.initial_centroids = kmeans::io::centroids(
+        args.initial_centroids_path, data.clusters, data.dimension);
+  }
+
   double start = MPI_Wtime();
 
   kmeans::run(&data, args.repetitions);
@@ -94,7 +556,13 @@ int main(int argc, char *argv[])
   if (data.rank == 0) {
     std::cout << duration << std::endl;
     kmeans::io::output(data.lowest_cost_point_clusters, data.amount,
-                       args.output_csv_path);
+                       args.output_csv_path, args.binary_output);
+
+    if (!args.centroids_path.empty()) {
+      kmeans::io::output_centroids(data.lowest_cost_centroids, data.clusters,
+                                   data.dimension, data.lowest_cost,
+                                   args.centroids_path);
+    }
   }
 
   MPI_Finalize();
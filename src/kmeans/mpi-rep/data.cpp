@@ -1,25 +1,47 @@
 #include <kmeans/mpi-rep/data.hpp>
 
+#include <kmeans/gemm.hpp>
+#include <kmeans/io.hpp>
+
 #include <algorithm>
 
 namespace kmeans {
 
-data::data(double *points,
+data::data(real *points,
            uint32_t amount,
            uint16_t clusters,
            uint32_t dimension,
            int processes,
-           int rank)
+           int rank,
+           kmeans::assignment assignment,
+           kmeans::kernel kernel,
+           kmeans::seeding seeding,
+           uint32_t batch_size,
+           uint32_t batch_iterations,
+           bool batch_refine,
+           uint32_t incremental)
     : points(points),
       amount(amount),
       clusters(clusters),
       dimension(dimension),
       processes(processes),
-      rank(rank)
+      rank(rank),
+      assignment(assignment),
+      bounds(kmeans::bounds(assignment, clusters)),
+      kernel(kernel),
+      seeding(seeding),
+      batch_size(batch_size),
+      batch_iterations(batch_iterations),
+      batch_refine(batch_refine),
+      fused(accumulation::fused(clusters, dimension)),
+      incremental(fused ? incremental : 0)
 {
   point_clusters = new uint16_t[amount]();
   lowest_cost_point_clusters = new uint16_t[amount]();
-  centroids = new double[clusters * dimension]();
+  lowest_cost_centroids = new real[clusters * dimension]();
+  centroids = new real[clusters * dimension]();
+  previous_centroids = new real[clusters * dimension]();
+  centroid_sums = new double[clusters * dimension]();
   centroid_point_indices = new uint32_t[clusters]();
   cluster_sizes = new uint32_t[clusters]();
 
@@ -27,19 +49,80 @@ data::data(double *points,
   // centroids.
   dist = new std::uniform_int_distribution<uint32_t>(0, amount - 1);
   mt = new std::mt19937(static_cast<uint64_t>(rank));
+
+  if (assignment != kmeans::assignment::lloyd) {
+    upper_bounds = new double[amount]();
+    lower_bounds = new double[static_cast<size_t>(amount) * bounds]();
+    centroid_drifts = new double[clusters]();
+  }
+
+  if (assignment == kmeans::assignment::elkan) {
+    centroid_distances = new double[static_cast<size_t>(clusters) * clusters]();
+  }
+
+  if (assignment == kmeans::assignment::elkan ||
+      assignment == kmeans::assignment::hamerly) {
+    centroid_bounds = new double[clusters]();
+  }
+
+  if (assignment == kmeans::assignment::yinyang) {
+    centroid_groups = new uint16_t[clusters]();
+    group_centroids = new uint16_t[clusters]();
+    group_offsets = new uint32_t[bounds + 1]();
+    group_drifts = new double[bounds]();
+  }
+
+  if (kernel == kmeans::kernel::gemm) {
+    point_norms = new double[amount]();
+    centroid_norms = new double[clusters]();
+    packed_centroids = new real[gemm::packed_size(clusters, dimension)]();
+
+    gemm::norms(points, point_norms, amount, dimension);
+  }
+
+  if (batch_size > 0) {
+    batch_points = new uint32_t[batch_size]();
+    batch_clusters = new uint16_t[batch_size]();
+    batch_centroids = new double[clusters * dimension]();
+    batch_cluster_sizes = new uint32_t[clusters]();
+  }
 }
 
 data::~data()
 {
-  delete[] points;
+  io::release(points);
+  io::release(initial_centroids);
+  accumulation::release(buffer);
   delete[] point_clusters;
   delete[] lowest_cost_point_clusters;
+  delete[] lowest_cost_centroids;
   delete[] centroids;
+  delete[] centroid_sums;
   delete[] centroid_point_indices;
   delete[] cluster_sizes;
 
   delete dist;
   delete mt;
+
+  delete[] upper_bounds;
+  delete[] lower_bounds;
+  delete[] previous_centroids;
+  delete[] centroid_drifts;
+  delete[] centroid_distances;
+  delete[] centroid_bounds;
+  delete[] centroid_groups;
+  delete[] group_centroids;
+  delete[] group_offsets;
+  delete[] group_drifts;
+
+  delete[] point_norms;
+  delete[] centroid_norms;
+  delete[] packed_centroids;
+
+  delete[] batch_points;
+  delete[] batch_clusters;
+  delete[] batch_centroids;
+  delete[] batch_cluster_sizes;
 }
 
 }
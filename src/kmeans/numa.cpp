@@ -0,0 +1,158 @@
+#include <kmeans/numa.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace kmeans {
+namespace numa {
+
+#ifdef __linux__
+static const std::string root = "/sys/devices/system/node";
+
+// Parses a CPU list like "0-3,8,10-11" and keeps the CPUs in allowed.
+static std::vector<int> cpus(const std::string &list, const cpu_set_t &allowed)
+{
+  std::vector<int> cpus;
+  size_t begin = 0;
+
+  while (begin < list.size()) {
+    size_t end = list.find(',', begin);
+    end = end == std::string::npos ? list.size() : end;
+
+    std::string range = list.substr(begin, end - begin);
+    size_t dash = range.find('-');
+
+    int first = std::atoi(range.c_str());
+    int last = dash == std::string::npos
+                   ? first
+                   : std::atoi(range.c_str() + dash + 1);
+
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(static_cast<size_t>(cpu), &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+
+    begin = end + 1;
+  }
+
+  return cpus;
+}
+#endif
+
+std::vector<node> nodes()
+{
+  std::vector<node> nodes;
+
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+
+  DIR *directory = opendir(root.c_str());
+
+  if (directory == nullptr ||
+      sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    if (directory != nullptr) {
+      closedir(directory);
+    }
+
+    return nodes;
+  }
+
+  while (dirent *entry = readdir(directory)) {
+    std::string name = entry->d_name;
+
+    if (name.compare(0, 4, "node") != 0 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos ||
+        name.size() == 4) {
+      continue;
+    }
+
+    std::ifstream file(root + "/" + name + "/cpulist");
+    std::string list;
+
+    if (!std::getline(file, list)) {
+      continue;
+    }
+
+    node node = {std::atoi(name.c_str() + 4), cpus(list, allowed)};
+
+    if (!node.cpus.empty()) {
+      nodes.push_back(node);
+    }
+  }
+
+  closedir(directory);
+
+  std::sort(nodes.begin(), nodes.end(),
+            [](const node &a, const node &b) { return a.id < b.id; });
+#endif
+
+  return nodes;
+}
+
+bool automatic()
+{
+  return std::getenv("OMP_NUM_THREADS") == nullptr &&
+         std::getenv("OMP_PLACES") == nullptr &&
+         std::getenv("OMP_PROC_BIND") == nullptr;
+}
+
+void pin(const node &node)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  for (int cpu : node.cpus) {
+    CPU_SET(static_cast<size_t>(cpu), &set);
+  }
+
+  sched_setaffinity(0, sizeof(set), &set);
+#else
+  (void)node;
+#endif
+}
+
+void place(const void *memory, size_t size, const node &node)
+{
+#ifdef __linux__
+  uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(memory);
+  uintptr_t end = begin + size;
+
+  // Pages shared with the memory of other nodes stay where they are.
+  begin = (begin + page - 1) / page * page;
+  end = end / page * page;
+
+  const size_t bits = 8 * sizeof(unsigned long);
+
+  if (begin >= end || node.id < 0 || static_cast<size_t>(node.id) >= bits) {
+    return;
+  }
+
+  unsigned long mask = 1UL << node.id;
+
+  // The kernel only reads maxnode - 1 bits of the mask.
+  syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED, &mask, bits + 1,
+          MPOL_MF_MOVE);
+#else
+  (void)memory;
+  (void)size;
+  (void)node;
+#endif
+}
+
+}
+}
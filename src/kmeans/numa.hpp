@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace kmeans {
+namespace numa {
+
+// NUMA topology of the machine as read from /sys/devices/system/node (Linux
+// only). The parallel implementations use it to place their threads and data
+// when the OpenMP environment doesn't (see automatic()).
+
+struct node {
+  int id;
+
+  // CPUs of the node that the process may run on.
+  std::vector<int> cpus;
+};
+
+// Nodes with at least one CPU the process may run on. Empty when the topology
+// can't be read.
+std::vector<node> nodes();
+
+// Whether the threads are left for the implementation to place, which is the
+// case unless one of OMP_NUM_THREADS, OMP_PLACES and OMP_PROC_BIND is set.
+bool automatic();
+
+// Pins the calling thread to the CPUs of node. Threads it starts afterwards
+// inherit the CPUs.
+void pin(const node &node);
+
+// Moves the pages of size bytes of memory that are already allocated to node
+// and lets the pages allocated later prefer it. Only whole pages are moved and
+// failures are ignored, placement is only an optimization.
+void place(const void *memory, size_t size, const node &node);
+
+}
+}
@@ -1,75 +1,323 @@
 #include <kmeans/omp-group/data.hpp>
 
+#include <kmeans/disk.hpp>
+#include <kmeans/gemm.hpp>
+#include <kmeans/io.hpp>
+
+#include <thread>
+
 namespace kmeans {
 
-data::data(double *points,
+static std::vector<numa::node> socket_nodes()
+{
+  if (!numa::automatic()) {
+    return {};
+  }
+
+  std::vector<numa::node> nodes = numa::nodes();
+
+  // A single node has nothing to place.
+  return nodes.size() > 1 ? nodes : std::vector<numa::node>();
+}
+
+int32_t enter(const data *data)
+{
+  int32_t socket = omp_get_thread_num();
+
+  if (!data->socket_nodes.empty()) {
+    const numa::node &node = data->socket_nodes[static_cast<size_t>(socket)];
+
+    numa::pin(node);
+    omp_set_num_threads(static_cast<int>(node.cpus.size()));
+  }
+
+  return socket;
+}
+
+void wait(barrier *barrier, uint32_t threads)
+{
+  uint32_t generation = barrier->generation.load(std::memory_order_acquire);
+
+  // The last thread resets the barrier before it releases the others, which
+  // can't arrive at it again before that.
+  if (barrier->waiting.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+      threads) {
+    barrier->waiting.store(0, std::memory_order_relaxed);
+    barrier->generation.fetch_add(1, std::memory_order_release);
+    return;
+  }
+
+  while (barrier->generation.load(std::memory_order_acquire) == generation) {
+    std::this_thread::yield();
+  }
+}
+
+data::data(real *points,
+           const csr::matrix &sparse_points,
            uint32_t amount,
            uint16_t clusters,
-           uint32_t dimension)
-    : points(points), amount(amount), clusters(clusters), dimension(dimension)
+           uint32_t dimension,
+           kmeans::assignment assignment,
+           kmeans::kernel kernel,
+           kmeans::seeding seeding,
+           uint32_t batch_size,
+           uint32_t batch_iterations,
+           bool batch_refine,
+           uint32_t incremental,
+           const std::string &out_of_core_directory)
+    : points(points),
+      amount(amount),
+      clusters(clusters),
+      dimension(dimension),
+      socket_nodes(kmeans::socket_nodes()),
+      sockets(socket_nodes.empty()
+                  ? static_cast<uint32_t>(std::max(omp_get_max_threads(), 1))
+                  : static_cast<uint32_t>(socket_nodes.size())),
+      assignment(assignment),
+      bounds(kmeans::bounds(assignment, clusters)),
+      kernel(kernel),
+      seeding(seeding),
+      batch_size(batch_size),
+      batch_iterations(batch_iterations),
+      batch_refine(batch_refine),
+      out_of_core(!out_of_core_directory.empty()),
+      window(out_of_core ? disk::window(dimension) : std::max(amount, 1u)),
+      sparse(sparse_points.offsets != nullptr),
+      sparse_points(sparse_points),
+      fused(accumulation::fused(clusters, dimension)),
+      incremental(fused ? incremental : 0)
 {
-  lowest_cost_point_clusters = new uint16_t[amount]();
+  if (out_of_core) {
+    lowest_cost_point_clusters = disk::clusters(out_of_core_directory, amount);
+  } else {
+    lowest_cost_point_clusters = new uint16_t[amount]();
+  }
+
+  lowest_cost_centroids = new real[clusters * dimension]();
   centroid_point_indices = new uint32_t[clusters]();
 
   dist = new std::uniform_int_distribution<uint32_t>(0, amount - 1);
   mt = new std::mt19937(0);
 
-  uint32_t sockets = static_cast<uint32_t>(std::max(omp_get_max_threads(), 1));
-
-  socket_points = new double *[sockets];
+  socket_points = new real *[sockets];
   socket_point_clusters = new uint16_t *[sockets];
-  socket_centroids = new double *[sockets];
+  socket_centroids = new real *[sockets];
+  socket_centroid_sums = new double *[sockets];
   socket_cluster_sizes = new uint32_t *[sockets];
   socket_point_displs = new uint32_t[sockets];
   socket_point_amounts = new uint32_t[sockets];
+  socket_buffers = new accumulation::buffer[sockets];
+  previous_centroids = new real[clusters * dimension]();
+  socket_barrier = new kmeans::barrier();
+
+  if (assignment != kmeans::assignment::lloyd) {
+    socket_upper_bounds = new double *[sockets];
+    socket_lower_bounds = new double *[sockets];
+    centroid_drifts = new double[clusters]();
+  }
+
+  if (assignment == kmeans::assignment::elkan) {
+    centroid_distances = new double[static_cast<size_t>(clusters) * clusters]();
+  }
+
+  if (assignment == kmeans::assignment::elkan ||
+      assignment == kmeans::assignment::hamerly) {
+    centroid_bounds = new double[clusters]();
+  }
 
+  if (assignment == kmeans::assignment::yinyang) {
+    centroid_groups = new uint16_t[clusters]();
+    group_centroids = new uint16_t[clusters]();
+    group_offsets = new uint32_t[bounds + 1]();
+    group_drifts = new double[bounds]();
+  }
+
+  if (kernel == kmeans::kernel::gemm) {
+    socket_point_norms = new double *[sockets];
+    centroid_norms = new double[clusters]();
+    packed_centroids = new real[gemm::packed_size(clusters, dimension)]();
+  }
+
+  if (sparse) {
+    socket_sparse_points = new csr::matrix[sockets];
+    centroid_norms = new double[clusters]();
+  }
+
+  if (fused && incremental > 0) {
+    centroid_sums = new double[clusters * dimension]();
+    cluster_sizes = new uint32_t[clusters]();
+  }
+
+  if (batch_size > 0) {
+    batch_points = new uint32_t[batch_size]();
+    batch_clusters = new uint16_t[batch_size]();
+    batch_centroids = new double[clusters * dimension]();
+    batch_cluster_sizes = new uint32_t[clusters]();
+  }
+
+  if (!socket_nodes.empty()) {
+    // The sockets start a parallel region of their own.
+    omp_set_max_active_levels(std::max(omp_get_max_active_levels(), 2));
+
+    // Starts the threads of parallel regions outside the sockets before the
+    // first socket is pinned, otherwise they'd inherit its node.
 #pragma omp parallel
+    {
+    }
+  }
+
+#pragma omp parallel num_threads(sockets)
   {
     int entities = static_cast<int>(sockets);
-    int socket = omp_get_thread_num();
+    int socket = enter(this);
 
     uint32_t socket_displ = divide::displ(amount, entities, socket);
     uint32_t socket_amount = divide::amount(amount, entities, socket);
 
-    socket_points[socket] = new double[socket_amount * dimension];
-    std::copy_n(points + socket_displ * dimension, socket_amount * dimension,
-                socket_points[socket]);
+    // The sockets work on their own part of the loaded points in place.
+    if (sparse) {
+      socket_points[socket] = nullptr;
+      socket_sparse_points[socket] = csr::slice(sparse_points, socket_displ);
+    } else {
+      socket_points[socket] = points + static_cast<size_t>(socket_displ) *
+                                           dimension;
+    }
+
+    // Moves the points of the socket to its node. The rest of its arrays are
+    // allocated and first touched below by its pinned thread.
+    if (!socket_nodes.empty() && !out_of_core) {
+      const numa::node &node = socket_nodes[static_cast<size_t>(socket)];
+
+      if (sparse) {
+        const csr::matrix &points = socket_sparse_points[socket];
+        uint64_t first = points.offsets[0];
+        uint64_t nonzeros = points.offsets[socket_amount] - first;
+
+        numa::place(points.indices + first, nonzeros * sizeof(uint32_t), node);
+        numa::place(points.values + first, nonzeros * sizeof(real), node);
+      } else {
+        numa::place(socket_points[socket],
+                    static_cast<size_t>(socket_amount) * dimension *
+                        sizeof(real),
+                    node);
+      }
+    }
 
-    socket_point_clusters[socket] = new uint16_t[socket_amount]();
-    socket_centroids[socket] = new double[clusters * dimension]();
+    if (out_of_core) {
+      socket_point_clusters[socket] = disk::clusters(out_of_core_directory,
+                                                     socket_amount);
+    } else {
+      socket_point_clusters[socket] = new uint16_t[socket_amount]();
+    }
+
+    socket_centroids[socket] = new real[clusters * dimension]();
+    socket_centroid_sums[socket] = new double[clusters * dimension]();
     socket_cluster_sizes[socket] = new uint32_t[clusters]();
 
     socket_point_displs[socket] = socket_displ;
     socket_point_amounts[socket] = socket_amount;
+
+    if (assignment != kmeans::assignment::lloyd) {
+      socket_upper_bounds[socket] = new double[socket_amount]();
+      socket_lower_bounds[socket] =
+          new double[static_cast<size_t>(socket_amount) * bounds]();
+    }
+
+    if (kernel == kmeans::kernel::gemm) {
+      socket_point_norms[socket] = new double[socket_amount]();
+      for (uint32_t first = 0; first < socket_amount; first += window) {
+        uint32_t count = std::min(window, socket_amount - first);
+
+        if (out_of_core) {
+          disk::advance(socket_points[socket], first, window, socket_amount,
+                        dimension);
+        }
+
+        gemm::norms(socket_points[socket] + static_cast<size_t>(first) *
+                                                dimension,
+                    socket_point_norms[socket] + first, count, dimension);
+      }
+    }
   }
 }
 
 data::~data()
 {
-  delete[] points;
-  delete[] lowest_cost_point_clusters;
+  io::release(points);
+  io::release(initial_centroids);
+  csr::release(sparse_points);
+
+  if (out_of_core) {
+    disk::release(lowest_cost_point_clusters, amount);
+  } else {
+    delete[] lowest_cost_point_clusters;
+  }
+
+  delete[] lowest_cost_centroids;
   delete[] centroid_point_indices;
 
   delete dist;
   delete mt;
 
-#pragma omp parallel
+#pragma omp parallel num_threads(sockets)
   {
-    int32_t socket = omp_get_thread_num();
+    int32_t socket = enter(this);
+
+    if (out_of_core) {
+      disk::release(socket_point_clusters[socket],
+                    socket_point_amounts[socket]);
+    } else {
+      delete[] socket_point_clusters[socket];
+    }
 
-    delete[] socket_points[socket];
-    delete[] socket_point_clusters[socket];
     delete[] socket_centroids[socket];
+    delete[] socket_centroid_sums[socket];
     delete[] socket_cluster_sizes[socket];
+    accumulation::release(socket_buffers[socket]);
+
+    if (assignment != kmeans::assignment::lloyd) {
+      delete[] socket_upper_bounds[socket];
+      delete[] socket_lower_bounds[socket];
+    }
+
+    if (kernel == kmeans::kernel::gemm) {
+      delete[] socket_point_norms[socket];
+    }
   }
 
   delete[] socket_points;
+  delete[] socket_sparse_points;
   delete[] socket_point_clusters;
   delete[] socket_centroids;
+  delete[] socket_centroid_sums;
   delete[] socket_cluster_sizes;
 
   delete[] socket_point_displs;
   delete[] socket_point_amounts;
+  delete[] socket_buffers;
+
+  delete[] socket_upper_bounds;
+  delete[] socket_lower_bounds;
+  delete[] previous_centroids;
+  delete socket_barrier;
+  delete[] centroid_sums;
+  delete[] cluster_sizes;
+  delete[] centroid_drifts;
+  delete[] centroid_distances;
+  delete[] centroid_bounds;
+  delete[] centroid_groups;
+  delete[] group_centroids;
+  delete[] group_offsets;
+  delete[] group_drifts;
+
+  delete[] socket_point_norms;
+  delete[] centroid_norms;
+  delete[] packed_centroids;
+
+  delete[] batch_points;
+  delete[] batch_clusters;
+  delete[] batch_centroids;
+  delete[] batch_cluster_sizes;
 }
 
 }
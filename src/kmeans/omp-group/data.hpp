@@ -1,16 +1,37 @@
 #pragma once
 
+#include <kmeans/accumulation.hpp>
+#include <kmeans/assignment.hpp>
+#include <kmeans/csr.hpp>
 #include <kmeans/divide.hpp>
+#include <kmeans/kernel.hpp>
+#include <kmeans/numa.hpp>
+#include <kmeans/real.hpp>
+#include <kmeans/seeding.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <omp.h>
 #include <random>
+#include <string>
+#include <vector>
 
 namespace kmeans {
 
+// Barrier of the threads that started the parallel regions of the sockets,
+// for use inside those regions where an omp barrier only waits for the
+// threads of one socket.
+struct barrier {
+  std::atomic<uint32_t> waiting{0};
+  std::atomic<uint32_t> generation{0};
+};
+
 struct data {
-  double *points;
+  real *points;
   uint16_t *lowest_cost_point_clusters;
+  real *lowest_cost_centroids;
+  double lowest_cost = std::numeric_limits<double>::max();
   uint32_t *centroid_point_indices;
 
   const uint32_t amount;
@@ -20,19 +41,105 @@ struct data {
   std::uniform_int_distribution<uint32_t> *dist;
   std::mt19937 *mt;
 
-  double **socket_points;
+  real **socket_points;
   uint16_t **socket_point_clusters;
-  double **socket_centroids;
+  real **socket_centroids;
+  double **socket_centroid_sums;
   uint32_t **socket_cluster_sizes;
   uint32_t *socket_point_displs;
   uint32_t *socket_point_amounts;
+  accumulation::buffer *socket_buffers;
+  real *previous_centroids;
+  kmeans::barrier *socket_barrier;
+
+  // Without OpenMP settings for the threads, a machine with several NUMA
+  // nodes gets a socket per node (see numa.hpp) whose threads only run on the
+  // node. Otherwise every thread of the OpenMP environment is a socket.
+  const std::vector<numa::node> socket_nodes;
+  const uint32_t sockets;
+
+  const kmeans::assignment assignment;
+  const uint32_t bounds;
+  const kmeans::kernel kernel;
+  const kmeans::seeding seeding;
+  const uint32_t batch_size;
+  const uint32_t batch_iterations;
+  const bool batch_refine;
+
+  // Out-of-core mode (see disk.hpp) goes over the points of each socket in
+  // windows of window points. Otherwise the window covers every point.
+  const bool out_of_core;
+  const uint32_t window;
+
+  // Sparse points (see csr.hpp) take the place of points, which is null. Every
+  // socket works on its slice of them.
+  const bool sparse;
+  const csr::matrix sparse_points;
+  csr::matrix *socket_sparse_points = nullptr;
+
+  // group() already sums the points of every cluster while it assigns them
+  // when fused (see accumulation.hpp), so centroids() doesn't read them again.
+  const bool fused;
 
-  const uint32_t sockets = static_cast<uint32_t>(
-      std::max(omp_get_max_threads(), 1));
+  // Period of the incremental iterations (see accumulation::incremental()), 0
+  // unless the sums are fused.
+  const uint32_t incremental;
 
-  data(double *points, uint32_t amount, uint16_t clusters, uint32_t dimension);
+  // Only allocated for incremental iterations, which keep the sums of every
+  // socket here since the sums of the sockets only hold their change.
+  double *centroid_sums = nullptr;
+  uint32_t *cluster_sizes = nullptr;
+
+  // Only allocated when the assignment algorithm keeps bounds.
+  double **socket_upper_bounds = nullptr;
+  double **socket_lower_bounds = nullptr;
+  double *centroid_drifts = nullptr;
+  double *centroid_distances = nullptr;
+  double *centroid_bounds = nullptr;
+  uint16_t *centroid_groups = nullptr;
+  uint16_t *group_centroids = nullptr;
+  uint32_t *group_offsets = nullptr;
+  double *group_drifts = nullptr;
+
+  // Only allocated for the gemm kernel (and the centroid norms for sparse
+  // points).
+  double **socket_point_norms = nullptr;
+  double *centroid_norms = nullptr;
+  real *packed_centroids = nullptr;
+
+  // Only loaded when seeding from given centroids.
+  real *initial_centroids = nullptr;
+
+  // Only allocated for mini-batch k-means.
+  uint32_t *batch_points = nullptr;
+  uint16_t *batch_clusters = nullptr;
+  double *batch_centroids = nullptr;
+  uint32_t *batch_cluster_sizes = nullptr;
+
+  data(real *points,
+       const csr::matrix &sparse_points,
+       uint32_t amount,
+       uint16_t clusters,
+       uint32_t dimension,
+       kmeans::assignment assignment,
+       kmeans::kernel kernel,
+       kmeans::seeding seeding,
+       uint32_t batch_size,
+       uint32_t batch_iterations,
+       bool batch_refine,
+       uint32_t incremental,
+       const std::string &out_of_core_directory);
 
   ~data();
 };
 
+// Returns the socket of the calling thread in a parallel region over the
+// sockets. When the socket has a node the thread is pinned to it and the
+// parallel regions it starts get a thread per CPU of the node.
+int32_t enter(const data *data);
+
+// Waits until threads threads called wait() on barrier, yielding the CPU while
+// spinning.
+void wait(barrier *barrier, uint32_t threads);
+
 }
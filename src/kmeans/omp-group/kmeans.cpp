@@ -1,34 +1,79 @@
+#include <kmeans/accumulation.hpp>
+#include <kmeans/csr.hpp>
+#include <kmeans/disk.hpp>
 #include <kmeans/distance.hpp>
+#include <kmeans/elkan.hpp>
+#include <kmeans/gemm.hpp>
+#include <kmeans/hamerly.hpp>
 #include <kmeans/io.hpp>
+#include <kmeans/lloyd.hpp>
+#include <kmeans/minibatch.hpp>
 #include <kmeans/random.hpp>
+#include <kmeans/scalable.hpp>
+#include <kmeans/yinyang.hpp>
 
 #include <kmeans/omp-group/data.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <omp.h>
+#include <vector>
 
 namespace kmeans {
 
+// Returns the end of the window of points of socket that starts at first and
+// prepares its points in out-of-core mode. Called by every thread of the
+// socket.
+static uint32_t window(data *data, int32_t socket, uint32_t first)
+{
+  uint32_t amount = data->socket_point_amounts[socket];
+
+  if (data->out_of_core) {
+#pragma omp single
+    disk::advance(data->socket_points[socket], first, data->window, amount,
+                  data->dimension);
+  }
+
+  return first + std::min(data->window, amount - first);
+}
+
 static double cost(data *data)
 {
   double cost = 0;
 
-#pragma omp parallel reduction(+ : cost)
+  if (data->sparse) {
+    gemm::norms(data->socket_centroids[0], data->centroid_norms,
+                data->clusters, data->dimension);
+  }
+
+#pragma omp parallel num_threads(data->sockets) reduction(+ : cost)
   {
-    int32_t socket = omp_get_thread_num();
+    int32_t socket = enter(data);
 
-    double *points = data->socket_points[socket];
+    real *points = data->socket_points[socket];
     uint16_t *point_clusters = data->socket_point_clusters[socket];
-    double *centroids = data->socket_centroids[socket];
+    real *centroids = data->socket_centroids[socket];
     uint32_t amount = data->socket_point_amounts[socket];
 
     double socket_cost = 0;
 
-#pragma omp parallel for reduction(+ : socket_cost) schedule(static)
-    for (uint32_t i = 0; i < amount; i++) {
-      double *point = points + i * data->dimension;
-      double *centroid = centroids + point_clusters[i] * data->dimension;
-
-      socket_cost += distance(point, centroid, data->dimension);
+#pragma omp parallel reduction(+ : socket_cost)
+    for (uint32_t first = 0; first < amount; first += data->window) {
+      uint32_t last = window(data, socket, first);
+
+#pragma omp for schedule(static)
+      for (uint32_t i = first; i < last; i++) {
+        uint16_t cluster = point_clusters[i];
+        real *centroid = centroids + cluster * data->dimension;
+
+        if (data->sparse) {
+          socket_cost += csr::distance(data->socket_sparse_points[socket], i,
+                                       centroid, data->centroid_norms[cluster]);
+        } else {
+          real *point = points + static_cast<size_t>(i) * data->dimension;
+          socket_cost += distance(point, centroid, data->dimension);
+        }
+      }
     }
 
     cost += socket_cost;
@@ -37,160 +82,465 @@ static double cost(data *data)
   return cost;
 }
 
-static void centroids(data *data)
+// Waits for every thread of every socket. Called by every thread of the
+// parallel regions of the sockets in run(), in which an omp barrier only waits
+// for the threads of the same socket.
+static void synchronize(data *data)
 {
-#pragma omp parallel
-  {
-    int32_t socket = omp_get_thread_num();
-    std::fill_n(data->socket_centroids[socket],
-                data->clusters * data->dimension, 0);
-    std::fill_n(data->socket_cluster_sizes[socket], data->clusters, 0);
+#pragma omp barrier
+
+  if (omp_get_thread_num() == 0) {
+    wait(data->socket_barrier, data->sockets);
   }
 
-#pragma omp parallel
-  {
-    int32_t socket = omp_get_thread_num();
+#pragma omp barrier
+}
 
-    double *points = data->socket_points[socket];
-    uint16_t *point_clusters = data->socket_point_clusters[socket];
-    double *centroids = data->socket_centroids[socket];
-    uint32_t *cluster_sizes = data->socket_cluster_sizes[socket];
-    uint32_t amount = data->socket_point_amounts[socket];
+// Computes the centroids of the clusters from the points of every socket.
+// Called by every thread of the sockets in run(): each socket first sums its
+// own points, after which it combines the sums of its range of the clusters
+// and computes their centroids.
+// Moved adds the change of the sums to the sums of the previous iteration
+// (see accumulation::incremental()).
+static void centroids(data *data, int32_t socket, bool moved)
+{
+  real *points = data->socket_points[socket];
+  uint16_t *point_clusters = data->socket_point_clusters[socket];
+  double *centroid_sums = data->socket_centroid_sums[socket];
+  uint32_t *cluster_sizes = data->socket_cluster_sizes[socket];
+  uint32_t amount = data->socket_point_amounts[socket];
+
+  accumulation::buffer *buffer = data->socket_buffers + socket;
+
+  // Unless group() already summed the points (see data::fused).
+  if (!data->fused) {
+    for (uint32_t first = 0; first < amount; first += data->window) {
+      uint32_t last = window(data, socket, first);
+
+      if (data->sparse) {
+        accumulation::team::accumulate(
+            buffer, csr::slice(data->socket_sparse_points[socket], first),
+            point_clusters + first, last - first, centroid_sums, cluster_sizes,
+            data->clusters, data->dimension);
+      } else {
+        accumulation::team::accumulate(
+            buffer, points + static_cast<size_t>(first) * data->dimension,
+            point_clusters + first, last - first, centroid_sums,
+            cluster_sizes, data->clusters, data->dimension);
+      }
+    }
+  }
 
-    for (uint32_t i = 0; i < amount; i++) {
-      uint16_t cluster = point_clusters[i];
-      cluster_sizes[cluster]++;
+  synchronize(data);
 
-      double *point = points + i * data->dimension;
-      double *centroid = centroids + cluster * data->dimension;
+  int entities = static_cast<int>(data->sockets);
+  uint16_t first = static_cast<uint16_t>(
+      divide::displ(data->clusters, entities, socket));
+  uint16_t count = static_cast<uint16_t>(
+      divide::amount(data->clusters, entities, socket));
 
-      for (uint32_t j = 0; j < data->dimension; j++) {
-        centroid[j] += point[j];
-      }
+  uint32_t offset = first * data->dimension;
+  real *centroids = data->socket_centroids[0] + offset;
+
+  // The copy is done before the reduction ends and average() starts.
+#pragma omp single nowait
+  std::copy_n(centroids, count * data->dimension,
+              data->previous_centroids + offset);
+
+  accumulation::team::reduce(data->socket_centroid_sums, data->sockets, offset,
+                             offset + count * data->dimension);
+
+#pragma omp for schedule(static)
+  for (uint16_t j = first; j < first + count; j++) {
+    for (uint32_t i = 1; i < data->sockets; i++) {
+      data->socket_cluster_sizes[0][j] += data->socket_cluster_sizes[i][j];
     }
   }
 
-  for (uint32_t i = 1; i < data->sockets; i++) {
-    for (uint16_t j = 0; j < data->clusters; j++) {
-      data->socket_cluster_sizes[0][j] += data->socket_cluster_sizes[i][j];
+  double *sums = data->socket_centroid_sums[0];
+  uint32_t *sizes = data->socket_cluster_sizes[0];
 
-      double *zero_centroid = data->socket_centroids[0] + j * data->dimension;
-      double *socket_centroid = data->socket_centroids[i] + j * data->dimension;
+  if (data->incremental > 0) {
+#pragma omp for schedule(static) nowait
+    for (uint32_t j = offset; j < offset + count * data->dimension; j++) {
+      data->centroid_sums[j] = moved ? data->centroid_sums[j] + sums[j]
+                                     : sums[j];
+    }
 
-      for (uint32_t k = 0; k < data->dimension; k++) {
-        zero_centroid[k] += socket_centroid[k];
-      }
+#pragma omp for schedule(static)
+    for (uint16_t j = first; j < first + count; j++) {
+      data->cluster_sizes[j] = moved ? data->cluster_sizes[j] + sizes[j]
+                                     : sizes[j];
     }
+
+    sums = data->centroid_sums;
+    sizes = data->cluster_sizes;
   }
 
-  for (uint16_t i = 0; i < data->clusters; i++) {
-    double *centroid = data->socket_centroids[0] + i * data->dimension;
+  accumulation::team::average(sums + offset, sizes + first, centroids, count,
+                              data->dimension);
 
-    for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] /= data->socket_cluster_sizes[0][i];
-    }
+  if (data->assignment != assignment::lloyd) {
+#pragma omp single
+    drift(data->previous_centroids + offset, centroids,
+          data->centroid_drifts + first, count, data->dimension);
   }
+
+  synchronize(data);
 }
 
-static bool group(data *data)
+// Prepares the centroids for group(), by a single thread of the first socket.
+static void prepare(data *data)
 {
-  bool point_clusters_equal = true;
+  if (data->sparse) {
+    gemm::norms(data->socket_centroids[0], data->centroid_norms,
+                data->clusters, data->dimension);
+    return;
+  }
 
-#pragma omp parallel reduction(min : point_clusters_equal)
-  {
-    int32_t socket = omp_get_thread_num();
+  if (data->kernel == kernel::gemm) {
+    gemm::centroids(data->socket_centroids[0], data->centroid_norms,
+                    data->packed_centroids, data->clusters, data->dimension);
+    return;
+  }
 
-    double *points = data->socket_points[socket];
-    uint16_t *point_clusters = data->socket_point_clusters[socket];
-    double *centroids = data->socket_centroids[socket];
-    uint32_t amount = data->socket_point_amounts[socket];
+  if (data->assignment == assignment::elkan) {
+    elkan::centroids(data->socket_centroids[0], data->centroid_distances,
+                     data->centroid_bounds, data->clusters, data->dimension);
+  }
+
+  if (data->assignment == assignment::hamerly) {
+    hamerly::centroids(data->socket_centroids[0], data->centroid_bounds,
+                       data->clusters, data->dimension);
+  }
 
+  if (data->assignment == assignment::yinyang) {
+    yinyang::drifts(data->centroid_drifts, data->centroid_groups,
+                    data->group_drifts, data->clusters, data->bounds);
+  }
+}
+
+// Assigns the points of socket to their nearest centroid. Called by every
+// thread of the sockets in run(). Returns whether the points the calling
+// thread assigned kept their cluster.
+// Moved only sums the change of the sums with the points that changed cluster
+// (see accumulation::incremental()).
+static bool group(data *data, int32_t socket, bool moved)
+{
+  if (socket == 0) {
+#pragma omp single
+    prepare(data);
+  }
+
+  synchronize(data);
+
+  real *points = data->socket_points[socket];
+  uint16_t *point_clusters = data->socket_point_clusters[socket];
+  real *centroids = data->socket_centroids[socket];
+  uint32_t amount = data->socket_point_amounts[socket];
+
+  double *centroid_sums = data->socket_centroid_sums[socket];
+  uint32_t *cluster_sizes = data->socket_cluster_sizes[socket];
+  accumulation::buffer *buffer = data->socket_buffers + socket;
+
+#pragma omp single
+  {
     if (socket != 0) {
       std::copy_n(data->socket_centroids[0], data->clusters * data->dimension,
                   centroids);
     }
 
-    uint32_t socket_point_clusters_equal = true;
+    std::fill_n(centroid_sums, data->clusters * data->dimension, 0);
+    std::fill_n(cluster_sizes, data->clusters, 0);
+  }
+
+  if (data->fused) {
+    accumulation::team::reserve(buffer, data->clusters, data->dimension);
+  }
+
+  bool point_clusters_equal = true;
 
-    // clang-format off
-#pragma omp parallel for reduction(min : socket_point_clusters_equal) schedule(static)
-    // clang-format on
+  if (data->sparse) {
+    csr::matrix points = data->socket_sparse_points[socket];
+    accumulation::part part = {};
+
+    if (data->fused) {
+      part = accumulation::begin(buffer, data->clusters, data->dimension,
+                                 moved);
+    }
+
+#pragma omp for schedule(static)
     for (uint32_t i = 0; i < amount; i++) {
       uint16_t previous_cluster = point_clusters[i];
-      uint16_t cluster = previous_cluster;
+      uint16_t cluster = csr::nearest(points, i, previous_cluster, centroids,
+                                      data->centroid_norms, data->clusters,
+                                      data->dimension);
 
-      double *point = points + i * data->dimension;
-      double *centroid = centroids + cluster * data->dimension;
+      point_clusters_equal = point_clusters_equal &&
+                             previous_cluster == cluster;
+      point_clusters[i] = cluster;
 
-      double lowest_distance = kmeans::distance(point, centroid,
-                                                data->dimension);
+      if (data->fused) {
+        accumulation::add(part, previous_cluster, cluster, points, i,
+                          data->dimension);
+      }
+    }
 
-      for (uint16_t j = 0; j < previous_cluster; j++) {
-        centroid = centroids + j * data->dimension;
+    if (data->fused) {
+      accumulation::end(buffer, centroid_sums, cluster_sizes, data->clusters,
+                        data->dimension);
+    }
 
-        double distance = kmeans::distance(point, centroid, data->dimension);
+    return point_clusters_equal;
+  }
 
-        if (distance < lowest_distance) {
-          cluster = j;
-          lowest_distance = distance;
-        }
-      }
+  if (data->kernel == kernel::gemm) {
+    for (uint32_t first = 0; first < amount; first += data->window) {
+      uint32_t last = window(data, socket, first);
+
+      real *window_points = points + static_cast<size_t>(first) *
+                                         data->dimension;
+      double *point_norms = data->socket_point_norms[socket] + first;
+
+      point_clusters_equal =
+          (data->fused
+               ? gemm::team::assign(window_points, point_norms,
+                                    point_clusters + first, last - first,
+                                    data->packed_centroids,
+                                    data->centroid_norms, data->clusters,
+                                    data->dimension, buffer, centroid_sums,
+                                    cluster_sizes, moved)
+               : gemm::team::assign(window_points, point_norms,
+                                    point_clusters + first, last - first,
+                                    data->packed_centroids,
+                                    data->centroid_norms, data->clusters,
+                                    data->dimension)) &&
+          point_clusters_equal;
+    }
 
-      for (uint16_t j = static_cast<uint16_t>(previous_cluster + 1);
-           j < data->clusters; j++) {
-        centroid = centroids + j * data->dimension;
+    return point_clusters_equal;
+  }
 
-        double distance = kmeans::distance(point, centroid, data->dimension);
+  hamerly::drift drift = {};
 
-        if (distance < lowest_distance) {
-          cluster = j;
-          lowest_distance = distance;
-        }
+  if (data->assignment == assignment::hamerly) {
+    drift = hamerly::drifts(data->centroid_drifts, data->clusters);
+  }
+
+  double *upper_bounds = nullptr;
+  double *lower_bounds = nullptr;
+
+  if (data->assignment != assignment::lloyd) {
+    upper_bounds = data->socket_upper_bounds[socket];
+    lower_bounds = data->socket_lower_bounds[socket];
+  }
+
+  for (uint32_t first = 0; first < amount; first += data->window) {
+    uint32_t last = window(data, socket, first);
+    accumulation::part part = {};
+
+    if (data->fused) {
+      part = accumulation::begin(buffer, data->clusters, data->dimension,
+                                 moved);
+    }
+
+#pragma omp for schedule(static)
+    for (uint32_t i = first; i < last; i++) {
+      uint16_t previous_cluster = point_clusters[i];
+      uint16_t cluster = previous_cluster;
+
+      real *point = points + static_cast<size_t>(i) * data->dimension;
+
+      switch (data->assignment) {
+        case assignment::lloyd:
+          cluster = lloyd::nearest(point, cluster, centroids, data->clusters,
+                                   data->dimension);
+          break;
+        case assignment::elkan:
+          cluster = elkan::nearest(
+              point, cluster, centroids, data->centroid_distances,
+              data->centroid_bounds, data->centroid_drifts, upper_bounds + i,
+              lower_bounds + static_cast<size_t>(i) * data->bounds,
+              data->clusters, data->dimension);
+          break;
+        case assignment::hamerly:
+          cluster = hamerly::nearest(
+              point, cluster, centroids, data->centroid_bounds,
+              data->centroid_drifts, drift, upper_bounds + i,
+              lower_bounds + static_cast<size_t>(i) * data->bounds,
+              data->clusters, data->dimension);
+          break;
+        case assignment::yinyang:
+          cluster = yinyang::nearest(
+              point, cluster, centroids, data->centroid_groups,
+              data->group_centroids, data->group_offsets,
+              data->centroid_drifts, data->group_drifts, upper_bounds + i,
+              lower_bounds + static_cast<size_t>(i) * data->bounds,
+              data->bounds, data->dimension);
+          break;
       }
 
-      socket_point_clusters_equal = socket_point_clusters_equal &&
-                                    previous_cluster == cluster;
+      point_clusters_equal = point_clusters_equal &&
+                             previous_cluster == cluster;
       point_clusters[i] = cluster;
+
+      if (data->fused) {
+        accumulation::add(part, previous_cluster, cluster, point,
+                          data->dimension);
+      }
     }
 
-    point_clusters_equal = socket_point_clusters_equal;
-  };
+    if (data->fused) {
+      accumulation::end(buffer, centroid_sums, cluster_sizes, data->clusters,
+                        data->dimension);
+    }
+  }
 
   return point_clusters_equal;
 }
 
+static void seed(data *data)
+{
+  switch (data->seeding) {
+    case seeding::random:
+      if (data->sparse) {
+        csr::centroids(data->sparse_points, data->socket_centroids[0],
+                       data->centroid_point_indices, data->clusters,
+                       data->dimension, data->dist, data->mt);
+        break;
+      }
+
+      random::centroids(data->points, data->socket_centroids[0],
+                        data->centroid_point_indices, data->clusters,
+                        data->dimension, data->dist, data->mt);
+      break;
+    case seeding::kmeanspp:
+      if (data->sparse) {
+        csr::kmeanspp(data->sparse_points, data->socket_centroids[0],
+                      data->centroid_point_indices, data->amount,
+                      data->clusters, data->dimension, data->dist, data->mt);
+        break;
+      }
+
+      random::kmeanspp(data->points, data->socket_centroids[0],
+                       data->centroid_point_indices, data->amount,
+                       data->clusters, data->dimension, data->dist, data->mt);
+      break;
+    case seeding::scalable:
+      scalable::centroids(data->points, data->socket_centroids[0], data->amount,
+                          data->clusters, data->dimension, data->dist,
+                          data->mt);
+      break;
+    case seeding::given:
+      std::copy_n(data->initial_centroids, data->clusters * data->dimension,
+                  data->socket_centroids[0]);
+      break;
+  }
+}
+
+static void batches(data *data)
+{
+  std::fill_n(data->socket_cluster_sizes[0], data->clusters, 0);
+
+  for (uint32_t i = 0; i < data->batch_iterations; i++) {
+    minibatch::sample(data->batch_points, data->batch_size, data->dist,
+                      data->mt);
+    minibatch::assign(data->points, data->batch_points, data->batch_clusters,
+                      data->batch_size, data->socket_centroids[0],
+                      data->clusters, data->dimension);
+    minibatch::accumulate(data->points, data->batch_points,
+                          data->batch_clusters, data->batch_size,
+                          data->batch_centroids, data->batch_cluster_sizes,
+                          data->clusters, data->dimension);
+    minibatch::update(data->socket_centroids[0], data->socket_cluster_sizes[0],
+                      data->batch_centroids, data->batch_cluster_sizes,
+                      data->clusters, data->dimension);
+  }
+}
+
 static void run(data *data)
 {
-  random::centroids(data->points, data->socket_centroids[0],
-                    data->centroid_point_indices, data->clusters,
-                    data->dimension, data->dist, data->mt);
+  seed(data);
 
-#pragma omp parallel
+  if (data->batch_size > 0) {
+    batches(data);
+  }
+
+  if (data->assignment != assignment::lloyd) {
+    std::fill_n(data->centroid_drifts, data->clusters, 0);
+  }
+
+  if (data->assignment == assignment::yinyang) {
+    yinyang::partition(data->socket_centroids[0], data->centroid_groups,
+                       data->group_centroids, data->group_offsets,
+                       data->clusters, data->bounds, data->dimension);
+  }
+
+  // Last iteration in which a point of each socket changed its cluster. The
+  // threads store the iteration instead of clearing a flag so the values don't
+  // need to be reset between iterations.
+  auto socket_iterations = std::vector<uint32_t>(
+      data->sockets, std::numeric_limits<uint32_t>::max());
+
+  // The sockets and their threads stay in parallel regions for every
+  // iteration, which only synchronizes them with barriers instead of starting
+  // parallel regions per step.
+#pragma omp parallel num_threads(data->sockets)
   {
-    int32_t socket = omp_get_thread_num();
+    int32_t socket = enter(data);
     std::fill_n(data->socket_point_clusters[socket],
                 data->socket_point_amounts[socket], 0);
-  }
 
-  while (!group(data)) {
-    centroids(data);
+    if (data->assignment != assignment::lloyd) {
+      reset(data->socket_upper_bounds[socket],
+            data->socket_lower_bounds[socket],
+            data->socket_point_amounts[socket], data->bounds);
+    }
+
+#pragma omp parallel
+    {
+      // Mini-batch k-means only needs a single pass over every point to
+      // assign each point to its nearest centroid unless asked to refine the
+      // centroids.
+      if (data->batch_size > 0 && !data->batch_refine) {
+        group(data, socket, false);
+      } else {
+        for (uint32_t iteration = 0;; iteration++) {
+          bool moved = accumulation::incremental(data->incremental, iteration);
+
+          if (!group(data, socket, moved)) {
+#pragma omp atomic write
+            socket_iterations[static_cast<size_t>(socket)] = iteration;
+          }
+
+          synchronize(data);
+
+          if (std::find(socket_iterations.begin(), socket_iterations.end(),
+                        iteration) == socket_iterations.end()) {
+            break;
+          }
+
+          centroids(data, socket, moved);
+        }
+      }
+    }
   }
 }
 
 void run(data *data, uint32_t repetitions)
 {
-  double lowest_cost = std::numeric_limits<double>::max();
-
   for (uint32_t i = 0; i < repetitions; i++) {
     run(data);
 
     double cost = kmeans::cost(data);
-    if (cost < lowest_cost) {
-      lowest_cost = cost;
+    if (cost < data->lowest_cost) {
+      data->lowest_cost = cost;
+      std::copy_n(data->socket_centroids[0], data->clusters * data->dimension,
+                  data->lowest_cost_centroids);
 
-#pragma omp parallel
+#pragma omp parallel num_threads(data->sockets)
       {
-        int32_t socket = omp_get_thread_num();
+        int32_t socket = enter(data);
         std::copy_n(data->socket_point_clusters[socket],
                     data->socket_point_amounts[socket],
                     data->lowest_cost_point_clusters +
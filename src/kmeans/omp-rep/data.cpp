@@ -1,39 +1,110 @@
 #include <kmeans/omp-rep/data.hpp>
 
+#include <kmeans/gemm.hpp>
+#include <kmeans/io.hpp>
+
 #include <algorithm>
 
 namespace kmeans {
 
-data::data(double *points,
+data::data(real *points,
            uint32_t amount,
            uint16_t clusters,
-           uint32_t dimension)
-    : points(points), amount(amount), clusters(clusters), dimension(dimension)
+           uint32_t dimension,
+           kmeans::assignment assignment,
+           kmeans::kernel kernel,
+           kmeans::seeding seeding,
+           uint32_t batch_size,
+           uint32_t batch_iterations,
+           bool batch_refine,
+           uint32_t incremental)
+    : points(points),
+      amount(amount),
+      clusters(clusters),
+      dimension(dimension),
+      assignment(assignment),
+      bounds(kmeans::bounds(assignment, clusters)),
+      kernel(kernel),
+      seeding(seeding),
+      batch_size(batch_size),
+      batch_iterations(batch_iterations),
+      batch_refine(batch_refine),
+      fused(accumulation::fused(clusters, dimension)),
+      incremental(fused ? incremental : 0)
 {
   lowest_cost_point_clusters = new uint16_t[amount]();
+  lowest_cost_centroids = new real[clusters * dimension]();
 
   uint32_t sockets = static_cast<uint32_t>(std::max(omp_get_max_threads(), 1));
 
-  socket_points = new double *[sockets];
+  socket_points = new real *[sockets];
   socket_point_clusters = new uint16_t *[sockets];
   socket_lowest_cost_point_clusters = new uint16_t *[sockets];
-  socket_centroids = new double *[sockets];
+  socket_lowest_cost_centroids = new real *[sockets];
+  socket_centroids = new real *[sockets];
+  socket_previous_centroids = new real *[sockets];
+  socket_centroid_sums = new double *[sockets];
   socket_centroid_point_indices = new uint32_t *[sockets];
   socket_cluster_sizes = new uint32_t *[sockets];
+  socket_buffers = new accumulation::buffer[sockets];
 
   socket_dist = new std::uniform_int_distribution<uint32_t> *[sockets];
   socket_mt = new std::mt19937 *[sockets];
 
+  if (assignment != kmeans::assignment::lloyd) {
+    socket_upper_bounds = new double *[sockets];
+    socket_lower_bounds = new double *[sockets];
+    socket_centroid_drifts = new double *[sockets];
+  }
+
+  if (assignment == kmeans::assignment::elkan) {
+    socket_centroid_distances = new double *[sockets];
+  }
+
+  if (assignment == kmeans::assignment::elkan ||
+      assignment == kmeans::assignment::hamerly) {
+    socket_centroid_bounds = new double *[sockets];
+  }
+
+  if (assignment == kmeans::assignment::yinyang) {
+    socket_centroid_groups = new uint16_t *[sockets];
+    socket_group_centroids = new uint16_t *[sockets];
+    socket_group_offsets = new uint32_t *[sockets];
+    socket_group_drifts = new double *[sockets];
+  }
+
+  if (kernel == kmeans::kernel::gemm) {
+    socket_point_norms = new double *[sockets];
+    socket_centroid_norms = new double *[sockets];
+    socket_packed_centroids = new real *[sockets];
+  }
+
+  if (batch_size > 0) {
+    socket_batch_points = new uint32_t *[sockets];
+    socket_batch_clusters = new uint16_t *[sockets];
+    socket_batch_centroids = new double *[sockets];
+    socket_batch_cluster_sizes = new uint32_t *[sockets];
+  }
+
 #pragma omp parallel
   {
     int32_t socket = omp_get_thread_num();
 
-    socket_points[socket] = new double[amount * dimension];
-    std::copy_n(points, amount * dimension, socket_points[socket]);
+    // The first socket uses the loaded points, the others get a replica.
+    if (socket == 0) {
+      socket_points[socket] = points;
+    } else {
+      size_t size = static_cast<size_t>(amount) * dimension;
+      socket_points[socket] = new real[size];
+      std::copy_n(points, size, socket_points[socket]);
+    }
 
     socket_point_clusters[socket] = new uint16_t[amount]();
     socket_lowest_cost_point_clusters[socket] = new uint16_t[amount]();
-    socket_centroids[socket] = new double[clusters * dimension]();
+    socket_lowest_cost_centroids[socket] = new real[clusters * dimension]();
+    socket_centroids[socket] = new real[clusters * dimension]();
+    socket_previous_centroids[socket] = new real[clusters * dimension]();
+    socket_centroid_sums[socket] = new double[clusters * dimension]();
     socket_centroid_point_indices[socket] = new uint32_t[clusters]();
     socket_cluster_sizes[socket] = new uint32_t[clusters]();
 
@@ -41,38 +112,146 @@ data::data(double *points,
                                                                       amount -
                                                                           1);
     socket_mt[socket] = new std::mt19937(static_cast<uint64_t>(socket));
+
+    if (assignment != kmeans::assignment::lloyd) {
+      socket_upper_bounds[socket] = new double[amount]();
+      socket_lower_bounds[socket] =
+          new double[static_cast<size_t>(amount) * bounds]();
+      socket_centroid_drifts[socket] = new double[clusters]();
+    }
+
+    if (assignment == kmeans::assignment::elkan) {
+      socket_centroid_distances[socket] =
+          new double[static_cast<size_t>(clusters) * clusters]();
+    }
+
+    if (assignment == kmeans::assignment::elkan ||
+        assignment == kmeans::assignment::hamerly) {
+      socket_centroid_bounds[socket] = new double[clusters]();
+    }
+
+    if (assignment == kmeans::assignment::yinyang) {
+      socket_centroid_groups[socket] = new uint16_t[clusters]();
+      socket_group_centroids[socket] = new uint16_t[clusters]();
+      socket_group_offsets[socket] = new uint32_t[bounds + 1]();
+      socket_group_drifts[socket] = new double[bounds]();
+    }
+
+    if (kernel == kmeans::kernel::gemm) {
+      socket_point_norms[socket] = new double[amount]();
+      socket_centroid_norms[socket] = new double[clusters]();
+      socket_packed_centroids[socket] =
+          new real[gemm::packed_size(clusters, dimension)]();
+
+      gemm::norms(socket_points[socket], socket_point_norms[socket], amount,
+                  dimension);
+    }
+
+    if (batch_size > 0) {
+      socket_batch_points[socket] = new uint32_t[batch_size]();
+      socket_batch_clusters[socket] = new uint16_t[batch_size]();
+      socket_batch_centroids[socket] = new double[clusters * dimension]();
+      socket_batch_cluster_sizes[socket] = new uint32_t[clusters]();
+    }
   }
 }
 
 data::~data()
 {
-  delete[] points;
+  io::release(points);
+  io::release(initial_centroids);
   delete[] lowest_cost_point_clusters;
+  delete[] lowest_cost_centroids;
 
 #pragma omp parallel
   {
     int32_t socket = omp_get_thread_num();
 
-    delete[] socket_points[socket];
+    if (socket != 0) {
+      delete[] socket_points[socket];
+    }
+
     delete[] socket_point_clusters[socket];
     delete[] socket_lowest_cost_point_clusters[socket];
+    delete[] socket_lowest_cost_centroids[socket];
     delete[] socket_centroids[socket];
+    delete[] socket_previous_centroids[socket];
+    delete[] socket_centroid_sums[socket];
     delete[] socket_centroid_point_indices[socket];
     delete[] socket_cluster_sizes[socket];
+    accumulation::release(socket_buffers[socket]);
 
     delete socket_dist[socket];
     delete socket_mt[socket];
+
+    if (assignment != kmeans::assignment::lloyd) {
+      delete[] socket_upper_bounds[socket];
+      delete[] socket_lower_bounds[socket];
+      delete[] socket_centroid_drifts[socket];
+    }
+
+    if (assignment == kmeans::assignment::elkan) {
+      delete[] socket_centroid_distances[socket];
+    }
+
+    if (assignment == kmeans::assignment::elkan ||
+        assignment == kmeans::assignment::hamerly) {
+      delete[] socket_centroid_bounds[socket];
+    }
+
+    if (assignment == kmeans::assignment::yinyang) {
+      delete[] socket_centroid_groups[socket];
+      delete[] socket_group_centroids[socket];
+      delete[] socket_group_offsets[socket];
+      delete[] socket_group_drifts[socket];
+    }
+
+    if (kernel == kmeans::kernel::gemm) {
+      delete[] socket_point_norms[socket];
+      delete[] socket_centroid_norms[socket];
+      delete[] socket_packed_centroids[socket];
+    }
+
+    if (batch_size > 0) {
+      delete[] socket_batch_points[socket];
+      delete[] socket_batch_clusters[socket];
+      delete[] socket_batch_centroids[socket];
+      delete[] socket_batch_cluster_sizes[socket];
+    }
   }
 
   delete[] socket_points;
   delete[] socket_point_clusters;
   delete[] socket_lowest_cost_point_clusters;
+  delete[] socket_lowest_cost_centroids;
   delete[] socket_centroids;
+  delete[] socket_previous_centroids;
+  delete[] socket_centroid_sums;
   delete[] socket_centroid_point_indices;
   delete[] socket_cluster_sizes;
+  delete[] socket_buffers;
 
   delete[] socket_dist;
   delete[] socket_mt;
+
+  delete[] socket_upper_bounds;
+  delete[] socket_lower_bounds;
+  delete[] socket_centroid_drifts;
+  delete[] socket_centroid_distances;
+  delete[] socket_centroid_bounds;
+  delete[] socket_centroid_groups;
+  delete[] socket_group_centroids;
+  delete[] socket_group_offsets;
+  delete[] socket_group_drifts;
+
+  delete[] socket_point_norms;
+  delete[] socket_centroid_norms;
+  delete[] socket_packed_centroids;
+
+  delete[] socket_batch_points;
+  delete[] socket_batch_clusters;
+  delete[] socket_batch_centroids;
+  delete[] socket_batch_cluster_sizes;
 }
 
 }
@@ -1,29 +1,93 @@
 #pragma once
 
+#include <kmeans/accumulation.hpp>
+#include <kmeans/assignment.hpp>
+#include <kmeans/kernel.hpp>
+#include <kmeans/real.hpp>
+#include <kmeans/seeding.hpp>
+
+#include <limits>
 #include <omp.h>
 #include <random>
 
 namespace kmeans {
 
 struct data {
-  double *points;
+  real *points;
   uint16_t *lowest_cost_point_clusters;
+  real *lowest_cost_centroids;
+  double lowest_cost = std::numeric_limits<double>::max();
 
   const uint32_t amount;
   const uint16_t clusters;
   const uint32_t dimension;
 
-  double **socket_points;
+  real **socket_points;
   uint16_t **socket_point_clusters;
   uint16_t **socket_lowest_cost_point_clusters;
-  double **socket_centroids;
+  real **socket_lowest_cost_centroids;
+  real **socket_centroids;
+  real **socket_previous_centroids;
+  double **socket_centroid_sums;
   uint32_t **socket_centroid_point_indices;
   uint32_t **socket_cluster_sizes;
+  accumulation::buffer *socket_buffers;
 
   std::uniform_int_distribution<uint32_t> **socket_dist;
   std::mt19937 **socket_mt;
 
-  data(double *points, uint32_t amount, uint16_t clusters, uint32_t dimension);
+  const kmeans::assignment assignment;
+  const uint32_t bounds;
+  const kmeans::kernel kernel;
+  const kmeans::seeding seeding;
+  const uint32_t batch_size;
+  const uint32_t batch_iterations;
+  const bool batch_refine;
+
+  // group() already sums the points of every cluster while it assigns them
+  // when fused (see accumulation.hpp), so centroids() doesn't read them again.
+  const bool fused;
+
+  // Period of the incremental iterations (see accumulation::incremental()), 0
+  // unless the sums are fused.
+  const uint32_t incremental;
+
+  // Only allocated when the assignment algorithm keeps bounds.
+  double **socket_upper_bounds = nullptr;
+  double **socket_lower_bounds = nullptr;
+  double **socket_centroid_drifts = nullptr;
+  double **socket_centroid_distances = nullptr;
+  double **socket_centroid_bounds = nullptr;
+  uint16_t **socket_centroid_groups = nullptr;
+  uint16_t **socket_group_centroids = nullptr;
+  uint32_t **socket_group_offsets = nullptr;
+  double **socket_group_drifts = nullptr;
+
+  // Only allocated for the gemm kernel.
+  double **socket_point_norms = nullptr;
+  double **socket_centroid_norms = nullptr;
+  real **socket_packed_centroids = nullptr;
+
+  // Only loaded when seeding from given centroids.
+  real *initial_centroids = nullptr;
+
+  // Only allocated for mini-batch k-means.
+  uint32_t **socket_batch_points = nullptr;
+  uint16_t **socket_batch_clusters = nullptr;
+  double **socket_batch_centroids = nullptr;
+  uint32_t **socket_batch_cluster_sizes = nullptr;
+
+  data(real *points,
+       uint32_t amount,
+       uint16_t clusters,
+       uint32_t dimension,
+       kmeans::assignment assignment,
+       kmeans::kernel kernel,
+       kmeans::seeding seeding,
+       uint32_t batch_size,
+       uint32_t batch_iterations,
+       bool batch_refine,
+       uint32_t incremental);
 
   ~data();
 };
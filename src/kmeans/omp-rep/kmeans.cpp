@@ -1,8 +1,16 @@
 #include <kmeans/omp-rep/kmeans.hpp>
 
+#include <kmeans/accumulation.hpp>
 #include <kmeans/distance.hpp>
+#include <kmeans/elkan.hpp>
+#include <kmeans/gemm.hpp>
+#include <kmeans/hamerly.hpp>
+#include <kmeans/lloyd.hpp>
+#include <kmeans/minibatch.hpp>
 #include <kmeans/omp-rep/data.hpp>
 #include <kmeans/random.hpp>
+#include <kmeans/scalable.hpp>
+#include <kmeans/yinyang.hpp>
 
 #include <kmeans/omp-rep/data.hpp>
 
@@ -14,16 +22,16 @@ static double cost(data *data)
 {
   int32_t socket = omp_get_thread_num();
 
-  double *points = data->socket_points[socket];
+  real *points = data->socket_points[socket];
   uint16_t *point_clusters = data->socket_point_clusters[socket];
-  double *centroids = data->socket_centroids[socket];
+  real *centroids = data->socket_centroids[socket];
 
   double cost = 0;
 
 #pragma omp parallel for reduction(+ : cost) schedule(static)
   for (uint32_t i = 0; i < data->amount; i++) {
-    double *point = points + i * data->dimension;
-    double *centroid = centroids + point_clusters[i] * data->dimension;
+    real *point = points + static_cast<size_t>(i) * data->dimension;
+    real *centroid = centroids + point_clusters[i] * data->dimension;
 
     cost += distance(point, centroid, data->dimension);
   }
@@ -35,107 +43,280 @@ static void centroids(data *data)
 {
   int32_t socket = omp_get_thread_num();
 
-  std::fill_n(data->socket_centroids[socket], data->clusters * data->dimension,
-              0);
-  std::fill_n(data->socket_cluster_sizes[socket], data->clusters, 0);
+  std::copy_n(data->socket_centroids[socket], data->clusters * data->dimension,
+              data->socket_previous_centroids[socket]);
 
-  double *points = data->socket_points[socket];
+  // Unless group() already summed the points (see data::fused).
+  if (!data->fused) {
+    accumulation::accumulate(
+        data->socket_buffers + socket, data->socket_points[socket],
+        data->socket_point_clusters[socket], data->amount,
+        data->socket_centroid_sums[socket], data->socket_cluster_sizes[socket],
+        data->clusters, data->dimension);
+  }
+
+  accumulation::average(data->socket_centroid_sums[socket],
+                        data->socket_cluster_sizes[socket],
+                        data->socket_centroids[socket], data->clusters,
+                        data->dimension);
+
+  if (data->assignment != assignment::lloyd) {
+    drift(data->socket_previous_centroids[socket],
+          data->socket_centroids[socket], data->socket_centroid_drifts[socket],
+          data->clusters, data->dimension);
+  }
+}
+
+// Moved only updates the sums of the previous iteration with the points that
+// changed cluster (see accumulation::incremental()).
+static bool group(data *data, bool moved)
+{
+  int32_t socket = omp_get_thread_num();
+
+  real *points = data->socket_points[socket];
   uint16_t *point_clusters = data->socket_point_clusters[socket];
-  double *centroids = data->socket_centroids[socket];
+  real *centroids = data->socket_centroids[socket];
+  double *centroid_sums = data->socket_centroid_sums[socket];
   uint32_t *cluster_sizes = data->socket_cluster_sizes[socket];
+  accumulation::buffer *buffer = data->socket_buffers + socket;
 
-  for (uint32_t i = 0; i < data->amount; i++) {
-    uint16_t cluster = point_clusters[i];
-    cluster_sizes[cluster]++;
+  if (!moved) {
+    std::fill_n(centroid_sums, data->clusters * data->dimension, 0);
+    std::fill_n(cluster_sizes, data->clusters, 0);
+  }
+
+  if (data->fused) {
+    accumulation::reserve(buffer, data->clusters, data->dimension);
+  }
+
+  if (data->kernel == kernel::gemm) {
+    double *centroid_norms = data->socket_centroid_norms[socket];
+    real *packed_centroids = data->socket_packed_centroids[socket];
 
-    double *point = points + i * data->dimension;
-    double *centroid = centroids + cluster * data->dimension;
+    gemm::centroids(centroids, centroid_norms, packed_centroids,
+                    data->clusters, data->dimension);
 
-    for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] += point[j];
+    if (data->fused) {
+      return gemm::assign(points, data->socket_point_norms[socket],
+                          point_clusters, data->amount, packed_centroids,
+                          centroid_norms, data->clusters, data->dimension,
+                          buffer, centroid_sums, cluster_sizes, moved);
     }
+
+    return gemm::assign(points, data->socket_point_norms[socket],
+                        point_clusters, data->amount, packed_centroids,
+                        centroid_norms, data->clusters, data->dimension);
   }
 
-  for (uint16_t i = 0; i < data->clusters; i++) {
-    double *centroid = data->socket_centroids[socket] + i * data->dimension;
+  double *upper_bounds = nullptr;
+  double *lower_bounds = nullptr;
+  double *centroid_drifts = nullptr;
+  double *centroid_distances = nullptr;
+  double *centroid_bounds = nullptr;
 
-    for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] /= data->socket_cluster_sizes[socket][i];
-    }
+  if (data->assignment != assignment::lloyd) {
+    upper_bounds = data->socket_upper_bounds[socket];
+    lower_bounds = data->socket_lower_bounds[socket];
+    centroid_drifts = data->socket_centroid_drifts[socket];
   }
-}
 
-static bool group(data *data)
-{
-  int32_t socket = omp_get_thread_num();
+  hamerly::drift drift = {};
 
-  double *points = data->socket_points[socket];
-  uint16_t *point_clusters = data->socket_point_clusters[socket];
-  double *centroids = data->socket_centroids[socket];
+  if (data->assignment == assignment::elkan) {
+    centroid_distances = data->socket_centroid_distances[socket];
+    centroid_bounds = data->socket_centroid_bounds[socket];
 
-  bool point_clusters_equal = true;
+    elkan::centroids(centroids, centroid_distances, centroid_bounds,
+                     data->clusters, data->dimension);
+  }
 
-#pragma omp parallel for reduction(min : point_clusters_equal) schedule(static)
-  for (uint32_t i = 0; i < data->amount; i++) {
-    uint16_t previous_cluster = point_clusters[i];
-    uint16_t cluster = previous_cluster;
+  if (data->assignment == assignment::hamerly) {
+    centroid_bounds = data->socket_centroid_bounds[socket];
 
-    double *point = points + i * data->dimension;
-    double *centroid = centroids + cluster * data->dimension;
+    hamerly::centroids(centroids, centroid_bounds, data->clusters,
+                       data->dimension);
+    drift = hamerly::drifts(centroid_drifts, data->clusters);
+  }
 
-    double lowest_distance = kmeans::distance(point, centroid, data->dimension);
+  uint16_t *centroid_groups = nullptr;
+  uint16_t *group_centroids = nullptr;
+  uint32_t *group_offsets = nullptr;
+  double *group_drifts = nullptr;
 
-    for (uint16_t j = 0; j < previous_cluster; j++) {
-      centroid = centroids + j * data->dimension;
+  if (data->assignment == assignment::yinyang) {
+    centroid_groups = data->socket_centroid_groups[socket];
+    group_centroids = data->socket_group_centroids[socket];
+    group_offsets = data->socket_group_offsets[socket];
+    group_drifts = data->socket_group_drifts[socket];
 
-      double distance = kmeans::distance(point, centroid, data->dimension);
+    yinyang::drifts(centroid_drifts, centroid_groups, group_drifts,
+                    data->clusters, data->bounds);
+  }
 
-      if (distance < lowest_distance) {
-        cluster = j;
-        lowest_distance = distance;
-      }
+  bool point_clusters_equal = true;
+
+#pragma omp parallel reduction(min : point_clusters_equal)
+  {
+    accumulation::part part = {};
+
+    if (data->fused) {
+      part = accumulation::begin(buffer, data->clusters, data->dimension,
+                                 moved);
     }
 
-    for (uint16_t j = static_cast<uint16_t>(previous_cluster + 1);
-         j < data->clusters; j++) {
-      centroid = centroids + j * data->dimension;
+#pragma omp for schedule(static)
+    for (uint32_t i = 0; i < data->amount; i++) {
+      uint16_t previous_cluster = point_clusters[i];
+      uint16_t cluster = previous_cluster;
+
+      real *point = points + static_cast<size_t>(i) * data->dimension;
+
+      switch (data->assignment) {
+        case assignment::lloyd:
+          cluster = lloyd::nearest(point, cluster, centroids, data->clusters,
+                                   data->dimension);
+          break;
+        case assignment::elkan:
+          cluster = elkan::nearest(
+              point, cluster, centroids, centroid_distances, centroid_bounds,
+              centroid_drifts, upper_bounds + i,
+              lower_bounds + static_cast<size_t>(i) * data->bounds,
+              data->clusters, data->dimension);
+          break;
+        case assignment::hamerly:
+          cluster = hamerly::nearest(
+              point, cluster, centroids, centroid_bounds, centroid_drifts,
+              drift, upper_bounds + i,
+              lower_bounds + static_cast<size_t>(i) * data->bounds,
+              data->clusters, data->dimension);
+          break;
+        case assignment::yinyang:
+          cluster = yinyang::nearest(
+              point, cluster, centroids, centroid_groups, group_centroids,
+              group_offsets, centroid_drifts, group_drifts, upper_bounds + i,
+              lower_bounds + static_cast<size_t>(i) * data->bounds,
+              data->bounds, data->dimension);
+          break;
+      }
 
-      double distance = kmeans::distance(point, centroid, data->dimension);
+      point_clusters_equal = point_clusters_equal != 0 &&
+                             previous_cluster == cluster;
+      point_clusters[i] = cluster;
 
-      if (distance < lowest_distance) {
-        cluster = j;
-        lowest_distance = distance;
+      if (data->fused) {
+        accumulation::add(part, previous_cluster, cluster, point,
+                          data->dimension);
       }
     }
 
-    point_clusters_equal = point_clusters_equal != 0 &&
-                           previous_cluster == cluster;
-    point_clusters[i] = cluster;
+    if (data->fused) {
+      accumulation::end(buffer, centroid_sums, cluster_sizes, data->clusters,
+                        data->dimension);
+    }
   }
 
   return point_clusters_equal;
 }
 
+static void seed(data *data)
+{
+  int32_t socket = omp_get_thread_num();
+
+  switch (data->seeding) {
+    case seeding::random:
+      random::centroids(data->points, data->socket_centroids[socket],
+                        data->socket_centroid_point_indices[socket],
+                        data->clusters, data->dimension,
+                        data->socket_dist[socket], data->socket_mt[socket]);
+      break;
+    case seeding::kmeanspp:
+      random::kmeanspp(data->points, data->socket_centroids[socket],
+                       data->socket_centroid_point_indices[socket],
+                       data->amount, data->clusters, data->dimension,
+                       data->socket_dist[socket], data->socket_mt[socket]);
+      break;
+    case seeding::scalable:
+      scalable::centroids(data->points, data->socket_centroids[socket],
+                          data->amount, data->clusters, data->dimension,
+                          data->socket_dist[socket], data->socket_mt[socket]);
+      break;
+    case seeding::given:
+      std::copy_n(data->initial_centroids, data->clusters * data->dimension,
+                  data->socket_centroids[socket]);
+      break;
+  }
+}
+
+static void batches(data *data)
+{
+  int32_t socket = omp_get_thread_num();
+
+  real *points = data->socket_points[socket];
+  real *centroids = data->socket_centroids[socket];
+  uint32_t *cluster_sizes = data->socket_cluster_sizes[socket];
+  uint32_t *batch_points = data->socket_batch_points[socket];
+  uint16_t *batch_clusters = data->socket_batch_clusters[socket];
+  double *batch_centroids = data->socket_batch_centroids[socket];
+  uint32_t *batch_cluster_sizes = data->socket_batch_cluster_sizes[socket];
+
+  std::fill_n(cluster_sizes, data->clusters, 0);
+
+  for (uint32_t i = 0; i < data->batch_iterations; i++) {
+    minibatch::sample(batch_points, data->batch_size, data->socket_dist[socket],
+                      data->socket_mt[socket]);
+    minibatch::assign(points, batch_points, batch_clusters, data->batch_size,
+                      centroids, data->clusters, data->dimension);
+    minibatch::accumulate(points, batch_points, batch_clusters,
+                          data->batch_size, batch_centroids,
+                          batch_cluster_sizes, data->clusters,
+                          data->dimension);
+    minibatch::update(centroids, cluster_sizes, batch_centroids,
+                      batch_cluster_sizes, data->clusters, data->dimension);
+  }
+}
+
 static void run(data *data)
 {
   int32_t socket = omp_get_thread_num();
 
-  random::centroids(data->points, data->socket_centroids[socket],
-                    data->socket_centroid_point_indices[socket], data->clusters,
-                    data->dimension, data->socket_dist[socket],
-                    data->socket_mt[socket]);
+  seed(data);
+
+  if (data->batch_size > 0) {
+    batches(data);
+  }
 
   std::fill_n(data->socket_point_clusters[socket], data->amount, 0);
 
-  while (!group(data)) {
+  if (data->assignment != assignment::lloyd) {
+    reset(data->socket_upper_bounds[socket], data->socket_lower_bounds[socket],
+          data->amount, data->bounds);
+    std::fill_n(data->socket_centroid_drifts[socket], data->clusters, 0);
+  }
+
+  if (data->assignment == assignment::yinyang) {
+    yinyang::partition(data->socket_centroids[socket],
+                       data->socket_centroid_groups[socket],
+                       data->socket_group_centroids[socket],
+                       data->socket_group_offsets[socket], data->clusters,
+                       data->bounds, data->dimension);
+  }
+
+  // Mini-batch k-means only needs a single pass over every point to assign
+  // each point to its nearest centroid unless asked to refine the centroids.
+  if (data->batch_size > 0 && !data->batch_refine) {
+    group(data, false);
+    return;
+  }
+
+  for (uint32_t iteration = 0;
+       !group(data, accumulation::incremental(data->incremental, iteration));
+       iteration++) {
     centroids(data);
   }
 }
 
 void run(data *data, uint32_t repetitions)
 {
-  double lowest_cost = std::numeric_limits<double>::max();
-
 #pragma omp parallel
   {
     int32_t socket = omp_get_thread_num();
@@ -152,14 +333,20 @@ void run(data *data, uint32_t repetitions)
         socket_lowest_cost = socket_cost;
         std::copy_n(data->socket_point_clusters[socket], data->amount,
                     data->socket_lowest_cost_point_clusters[socket]);
+        std::copy_n(data->socket_centroids[socket],
+                    data->clusters * data->dimension,
+                    data->socket_lowest_cost_centroids[socket]);
       }
     }
 
 #pragma omp critical
-    if (socket_lowest_cost < lowest_cost) {
-      lowest_cost = socket_lowest_cost;
+    if (socket_lowest_cost < data->lowest_cost) {
+      data->lowest_cost = socket_lowest_cost;
       std::copy_n(data->socket_lowest_cost_point_clusters[socket], data->amount,
                   data->lowest_cost_point_clusters);
+      std::copy_n(data->socket_lowest_cost_centroids[socket],
+                  data->clusters * data->dimension,
+                  data->lowest_cost_centroids);
     }
   }
 }
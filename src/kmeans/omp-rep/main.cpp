@@ -3,27 +3,31 @@
 #include <kmeans/omp-rep/data.hpp>
 #include <kmeans/omp-rep/kmeans.hpp>
 
-#include <algorithm>
 #include <iostream>
 #include <omp.h>
 
 static kmeans::data initialize(const kmeans::args &args)
 {
-  std::vector<std::vector<double>> points2D = kmeans::io::input(
-      args.input_csv_path);
-
-  uint32_t amount = static_cast<uint32_t>(points2D.size());
-  uint32_t dimension = static_cast<uint32_t>(points2D[0].size());
-  double *points = new double[amount * dimension]();
-
-  for (uint32_t i = 0; i < amount; i++) {
-    double *point = points + i * dimension;
-    double *point2D = &points2D[i].front();
+  if (!args.out_of_core_directory.empty()) {
+    throw kmeans::invalid_argument("--out-of-core",
+                                   args.out_of_core_directory +
+                                       " (requires seq or omp-group)");
+  }
 
-    std::copy_n(point2D, dimension, point);
+  if (args.sparse) {
+    throw kmeans::invalid_argument("--sparse",
+                                   "requires seq, omp-group or mpi-group");
   }
 
-  return kmeans::data(points, amount, args.clusters, dimension);
+  uint32_t amount;
+  uint32_t dimension;
+  kmeans::real *points = kmeans::io::input(args.input_csv_path, &amount,
+                                           &dimension);
+
+  return kmeans::data(points, amount, args.clusters, dimension,
+                      args.assignment, args.kernel, args.seeding,
+                      args.batch_size, args.batch_iterations,
+                      args.batch_refine, args.incremental);
 }
 
 int main(int argc, char *argv[])
@@ -31,6 +35,11 @@ int main(int argc, char *argv[])
   kmeans::args args = kmeans::args::parse(argc, argv);
   kmeans::data data = initialize(args);
 
+  if (args.seeding == kmeans::seeding::given) {
+    data.initial_centroids = kmeans::io::centroids(
+        args.initial_centroids_path, data.clusters, data.dimension);
+  }
+
   double start = omp_get_wtime();
 
   kmeans::run(&data, args.repetitions);
@@ -40,7 +49,13 @@ int main(int argc, char *argv[])
   std::cout << duration << std::endl;
 
   kmeans::io::output(data.lowest_cost_point_clusters, data.amount,
-                     args.output_csv_path);
+                     args.output_csv_path, args.binary_output);
+
+  if (!args.centroids_path.empty()) {
+    kmeans::io::output_centroids(data.lowest_cost_centroids, data.clusters,
+                                 data.dimension, data.lowest_cost,
+                                 args.centroids_path);
+  }
 
   return 0;
 }
@@ -0,0 +1,244 @@
+#include <kmeans/binary.hpp>
+#include <kmeans/gemm.hpp>
+#include <kmeans/io.hpp>
+#include <kmeans/lloyd.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Assigns the points in an input file to their nearest centroid in a model
+// written by --centroids and writes their clusters like the other executables:
+//
+//   predict --input points.csv --centroids model.csv --output clusters.csv
+//           [--kernel direct|gemm] [--binary-output]
+//
+// The input is streamed in windows of about window bytes, so only a window of
+// points and their clusters are kept in memory however large the input is.
+static const size_t window = size_t(1) << 24;
+
+static std::string argument(const std::vector<std::string> &raw_args,
+                            const std::string &argument,
+                            const std::string &fallback)
+{
+  auto position = std::find(raw_args.begin(), raw_args.end(), argument);
+
+  if (position != raw_args.end() && ++position != raw_args.end()) {
+    return *position;
+  }
+
+  return fallback;
+}
+
+// Reads the points of a binary point file window by window.
+class binary_reader {
+public:
+  explicit binary_reader(const std::string &path)
+      : path_(path),
+        header_(kmeans::binary::inspect(path)),
+        file_(path, std::ios::binary)
+  {
+    size_t row_size = header_.stride * kmeans::binary::size(header_.dtype);
+    window_amount_ = static_cast<uint32_t>(
+        std::max<size_t>(window / row_size, 1));
+  }
+
+  uint32_t dimension() const
+  {
+    return static_cast<uint32_t>(header_.dimension);
+  }
+
+  // Reads the next window of points into points (window_amount * dimension)
+  // and returns their amount, which is 0 at the end of the file.
+  uint32_t next(kmeans::real *points)
+  {
+    uint32_t amount = static_cast<uint32_t>(
+        std::min<uint64_t>(window_amount_, header_.amount - first_));
+
+    if (amount == 0) {
+      return 0;
+    }
+
+    size_t value_size = kmeans::binary::size(header_.dtype);
+    size_t row_size = header_.stride * value_size;
+    size_t length = (amount - 1) * row_size + header_.dimension * value_size;
+
+    bytes_.resize(length);
+    file_.seekg(static_cast<std::streamoff>(header_.offset +
+                                            first_ * row_size));
+    file_.read(bytes_.data(), static_cast<std::streamsize>(length));
+
+    if (!file_) {
+      throw std::runtime_error("Can't read '" + path_ + "'");
+    }
+
+    kmeans::binary::convert(bytes_.data(), header_, amount, points);
+    first_ += amount;
+
+    return amount;
+  }
+
+  uint32_t window_amount() const
+  {
+    return window_amount_;
+  }
+
+private:
+  const std::string path_;
+  const kmeans::binary::header header_;
+  std::ifstream file_;
+  std::vector<char> bytes_;
+  uint32_t window_amount_;
+  uint64_t first_ = 0;
+};
+
+// Assigns amount points to their nearest centroid in point_clusters.
+static void assign(kmeans::real *points,
+                   uint16_t *point_clusters,
+                   uint32_t amount,
+                   kmeans::real *centroids,
+                   kmeans::real *packed_centroids,
+                   double *centroid_norms,
+                   uint16_t clusters,
+                   uint32_t dimension,
+                   bool gemm)
+{
+  std::fill_n(point_clusters, amount, 0);
+
+  if (gemm) {
+    auto point_norms = std::vector<double>(amount);
+    kmeans::gemm::norms(points, point_norms.data(), amount, dimension);
+    kmeans::gemm::assign(points, point_norms.data(), point_clusters, amount,
+                         packed_centroids, centroid_norms, clusters,
+                         dimension);
+    return;
+  }
+
+#pragma omp parallel for schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    kmeans::real *point = points + static_cast<size_t>(i) * dimension;
+    point_clusters[i] = kmeans::lloyd::nearest(point, 0, centroids, clusters,
+                                               dimension);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  auto raw_args = std::vector<std::string>(argv + 1, argv + argc);
+
+  std::string input = argument(raw_args, "--input", "");
+  std::string model = argument(raw_args, "--centroids", "");
+  std::string output = argument(raw_args, "--output", "");
+  std::string kernel = argument(raw_args, "--kernel", "direct");
+  bool binary_output = std::find(raw_args.begin(), raw_args.end(),
+                                 "--binary-output") != raw_args.end();
+
+  if (input.empty() || model.empty() || output.empty() ||
+      (kernel != "direct" && kernel != "gemm")) {
+    std::cerr << "Usage: predict --input points.csv --centroids model.csv "
+                 "--output clusters.csv [--kernel direct|gemm] "
+                 "[--binary-output]"
+              << std::endl;
+    return 1;
+  }
+
+  uint32_t clusters;
+  uint32_t dimension;
+  kmeans::real *centroids = kmeans::io::input(model, &clusters, &dimension);
+
+  if (clusters > UINT16_MAX) {
+    throw std::runtime_error("Too many centroids in '" + model + "'");
+  }
+
+  auto k = static_cast<uint16_t>(clusters);
+  auto packed_centroids = std::vector<kmeans::real>(
+      kmeans::gemm::packed_size(k, dimension));
+  auto centroid_norms = std::vector<double>(k);
+  kmeans::gemm::centroids(centroids, centroid_norms.data(),
+                          packed_centroids.data(), k, dimension);
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::ofstream output_file(output, std::ios::binary);
+  kmeans::CSVWriter writer(output_file);
+  auto point_clusters = std::vector<uint16_t>();
+  uint64_t total = 0;
+
+  // Writes the clusters of a window of points and keeps count of the points.
+  auto predict = [&](kmeans::real *points, uint32_t amount) {
+    point_clusters.resize(amount);
+    assign(points, point_clusters.data(), amount, centroids,
+           packed_centroids.data(), centroid_norms.data(), k, dimension,
+           kernel == "gemm");
+
+    if (binary_output) {
+      output_file.write(reinterpret_cast<const char *>(point_clusters.data()),
+                        static_cast<std::streamsize>(amount *
+                                                     sizeof(uint16_t)));
+    } else {
+      writer.append(point_clusters.data(), amount);
+    }
+
+    total += amount;
+  };
+
+  if (kmeans::binary::detect(input)) {
+    binary_reader reader(input);
+
+    if (reader.dimension() != dimension) {
+      throw std::runtime_error("Expected points of dimension " +
+                               std::to_string(dimension) + " in '" + input +
+                               "'");
+    }
+
+    auto points = std::vector<kmeans::real>(
+        static_cast<size_t>(reader.window_amount()) * dimension);
+
+    for (uint32_t amount; (amount = reader.next(points.data())) > 0;) {
+      predict(points.data(), amount);
+    }
+  } else {
+    kmeans::CSVReader reader(input);
+    uint32_t amount;
+    uint32_t point_dimension;
+
+    for (kmeans::real *points; (points = reader.next(
+                                    window, &amount, &point_dimension)) !=
+                               nullptr;) {
+      if (point_dimension != dimension) {
+        delete[] points;
+        throw std::runtime_error("Expected points of dimension " +
+                                 std::to_string(dimension) + " in '" + input +
+                                 "'");
+      }
+
+      predict(points, amount);
+      delete[] points;
+    }
+  }
+
+  if (!binary_output) {
+    writer.end();
+  }
+
+  output_file.close();
+
+  if (!output_file) {
+    throw std::runtime_error("Can't write '" + output + "'");
+  }
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() -
+                                           start;
+
+  std::cout << duration.count() << std::endl;
+  std::cout << static_cast<double>(total) / duration.count() << " points/s"
+            << std::endl;
+
+  kmeans::io::release(centroids);
+
+  return 0;
+}
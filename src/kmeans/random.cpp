@@ -1,5 +1,9 @@
 #include <kmeans/random.hpp>
 
+#include <kmeans/distance.hpp>
+
+#include <vector>
+
 static bool contains(uint32_t *array, uint32_t size, uint32_t value)
 {
   for (uint32_t i = 0; i < size; i++) {
@@ -14,13 +18,10 @@ static bool contains(uint32_t *array, uint32_t size, uint32_t value)
 namespace kmeans {
 namespace random {
 
-void centroids(double *points,
-               double *centroids,
-               uint32_t *centroid_point_indices,
-               uint16_t clusters,
-               uint32_t dimension,
-               std::uniform_int_distribution<uint32_t> *dist,
-               std::mt19937 *mt)
+void indices(uint32_t *centroid_point_indices,
+             uint16_t clusters,
+             std::uniform_int_distribution<uint32_t> *dist,
+             std::mt19937 *mt)
 {
   for (uint16_t i = 0; i < clusters; i++) {
     uint32_t random_point = (*dist)(*mt);
@@ -31,14 +32,96 @@ void centroids(double *points,
 
     centroid_point_indices[i] = random_point;
   }
+}
+
+uint32_t weighted(const double *point_distances,
+                  uint32_t amount,
+                  double total,
+                  std::mt19937 *mt)
+{
+  double target = std::uniform_real_distribution<double>(0, total)(*mt);
+  double sum = 0;
+  uint32_t point = 0;
+
+  // Rounding errors might leave the target just past the last non-zero
+  // distance so we default to the last point that has one.
+  for (uint32_t i = 0; i < amount; i++) {
+    if (point_distances[i] > 0) {
+      point = i;
+      sum += point_distances[i];
+
+      if (sum > target) {
+        break;
+      }
+    }
+  }
+
+  return point;
+}
+
+void centroids(real *points,
+               real *centroids,
+               uint32_t *centroid_point_indices,
+               uint16_t clusters,
+               uint32_t dimension,
+               std::uniform_int_distribution<uint32_t> *dist,
+               std::mt19937 *mt)
+{
+  indices(centroid_point_indices, clusters, dist, mt);
 
   for (uint16_t i = 0; i < clusters; i++) {
-    double *centroid = centroids + i * dimension;
-    double *point = points + centroid_point_indices[i] * dimension;
+    real *centroid = centroids + i * dimension;
+    real *point = points +
+                  static_cast<size_t>(centroid_point_indices[i]) * dimension;
 
     std::copy_n(point, dimension, centroid);
   }
 }
 
+void kmeanspp(real *points,
+              real *centroids,
+              uint32_t *centroid_point_indices,
+              uint32_t amount,
+              uint16_t clusters,
+              uint32_t dimension,
+              std::uniform_int_distribution<uint32_t> *dist,
+              std::mt19937 *mt)
+{
+  auto point_distances = std::vector<double>(amount);
+  double total = 0;
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    uint32_t random_point = (*dist)(*mt);
+
+    if (i > 0 && total > 0) {
+      random_point = weighted(point_distances.data(), amount, total, mt);
+    }
+
+    centroid_point_indices[i] = random_point;
+
+    real *centroid = centroids + i * dimension;
+    real *point = points + static_cast<size_t>(random_point) * dimension;
+    std::copy_n(point, dimension, centroid);
+
+    if (i + 1 == clusters) {
+      break;
+    }
+
+    total = 0;
+
+#pragma omp parallel for reduction(+ : total) schedule(static)
+    for (uint32_t j = 0; j < amount; j++) {
+      double distance = kmeans::distance(
+          points + static_cast<size_t>(j) * dimension, centroid, dimension);
+
+      if (i == 0 || distance < point_distances[j]) {
+        point_distances[j] = distance;
+      }
+
+      total += point_distances[j];
+    }
+  }
+}
+
 }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <kmeans/real.hpp>
+
 #include <algorithm>
 #include <cstdint>
 #include <random>
@@ -7,13 +9,37 @@
 namespace kmeans {
 namespace random {
 
-void centroids(double *points,
-               double *centroids,
+// Picks clusters distinct random points in centroid_point_indices.
+void indices(uint32_t *centroid_point_indices,
+             uint16_t clusters,
+             std::uniform_int_distribution<uint32_t> *dist,
+             std::mt19937 *mt);
+
+// Picks one of amount points with a probability proportional to its distance
+// in point_distances, which add up to total (larger than 0).
+uint32_t weighted(const double *point_distances,
+                  uint32_t amount,
+                  double total,
+                  std::mt19937 *mt);
+
+void centroids(real *points,
+               real *centroids,
                uint32_t *centroid_point_indices,
                uint16_t clusters,
                uint32_t dimension,
                std::uniform_int_distribution<uint32_t> *dist,
                std::mt19937 *mt);
 
+// k-means++ seeding of amount points. The squared distances of the points to
+// their nearest centroid are updated in parallel after each picked centroid.
+void kmeanspp(real *points,
+              real *centroids,
+              uint32_t *centroid_point_indices,
+              uint32_t amount,
+              uint16_t clusters,
+              uint32_t dimension,
+              std::uniform_int_distribution<uint32_t> *dist,
+              std::mt19937 *mt);
+
 }
 }
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace kmeans {
+
+// Type the points and centroids are stored in. Building with KMEANS_FLOAT
+// stores them in single precision, which halves the memory traffic of the
+// distance computations and doubles the width of their SIMD kernels. Sums over
+// many points (centroids, costs) are accumulated in double precision either
+// way.
+// KMEANS_MPI_REAL is the matching MPI datatype for the backends that include
+// mpi.h.
+#ifdef KMEANS_FLOAT
+typedef float real;
+#define KMEANS_MPI_REAL MPI_FLOAT
+#else
+typedef double real;
+#define KMEANS_MPI_REAL MPI_DOUBLE
+#endif
+
+}
@@ -0,0 +1,165 @@
+#include <kmeans/scalable.hpp>
+
+#include <kmeans/distance.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace kmeans {
+namespace scalable {
+
+double update(real *points,
+              double *point_distances,
+              uint32_t *point_candidates,
+              uint32_t amount,
+              real *candidates,
+              uint32_t first_candidate,
+              uint32_t candidate_amount,
+              uint32_t dimension)
+{
+  double total = 0;
+
+#pragma omp parallel for reduction(+ : total) schedule(static)
+  for (uint32_t i = 0; i < amount; i++) {
+    real *point = points + static_cast<size_t>(i) * dimension;
+
+    for (uint32_t j = first_candidate; j < candidate_amount; j++) {
+      real *candidate = candidates + static_cast<size_t>(j) * dimension;
+      double distance = kmeans::distance(point, candidate, dimension);
+
+      if (distance < point_distances[i]) {
+        point_distances[i] = distance;
+        point_candidates[i] = j;
+      }
+    }
+
+    total += point_distances[i];
+  }
+
+  return total;
+}
+
+void sample(real *points,
+            double *point_distances,
+            uint32_t amount,
+            uint32_t dimension,
+            double factor,
+            double total,
+            std::mt19937 *mt,
+            std::vector<real> *candidates)
+{
+  if (total <= 0) {
+    return;
+  }
+
+  auto uniform = std::uniform_real_distribution<double>(0, 1);
+
+  for (uint32_t i = 0; i < amount; i++) {
+    if (uniform(*mt) * total < factor * point_distances[i]) {
+      real *point = points + static_cast<size_t>(i) * dimension;
+      candidates->insert(candidates->end(), point, point + dimension);
+    }
+  }
+}
+
+void weigh(uint32_t *point_candidates, uint32_t amount, uint32_t *weights)
+{
+  for (uint32_t i = 0; i < amount; i++) {
+    weights[point_candidates[i]]++;
+  }
+}
+
+void reduce(real *candidates,
+            uint32_t *weights,
+            uint32_t candidate_amount,
+            real *centroids,
+            uint16_t clusters,
+            uint32_t dimension,
+            std::mt19937 *mt)
+{
+  auto candidate_distances = std::vector<double>(
+      candidate_amount, std::numeric_limits<double>::max());
+  auto uniform = std::uniform_real_distribution<double>(0, 1);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    double total = 0;
+
+    for (uint32_t j = 0; j < candidate_amount; j++) {
+      // The first centroid is picked proportional to the weights only.
+      total += i == 0 ? weights[j] : weights[j] * candidate_distances[j];
+    }
+
+    double target = uniform(*mt) * total;
+    double sum = 0;
+    uint32_t picked = static_cast<uint32_t>(i) % candidate_amount;
+
+    for (uint32_t j = 0; j < candidate_amount && total > 0; j++) {
+      double weight = i == 0 ? weights[j] : weights[j] * candidate_distances[j];
+
+      if (weight > 0) {
+        picked = j;
+        sum += weight;
+
+        if (sum > target) {
+          break;
+        }
+      }
+    }
+
+    real *centroid = centroids + i * dimension;
+    real *candidate = candidates + static_cast<size_t>(picked) * dimension;
+    std::copy_n(candidate, dimension, centroid);
+
+    for (uint32_t j = 0; j < candidate_amount; j++) {
+      candidate = candidates + static_cast<size_t>(j) * dimension;
+      candidate_distances[j] = std::min(
+          candidate_distances[j],
+          kmeans::distance(candidate, centroid, dimension));
+    }
+  }
+}
+
+void centroids(real *points,
+               real *centroids,
+               uint32_t amount,
+               uint16_t clusters,
+               uint32_t dimension,
+               std::uniform_int_distribution<uint32_t> *dist,
+               std::mt19937 *mt)
+{
+  auto point_distances = std::vector<double>(
+      amount, std::numeric_limits<double>::max());
+  auto point_candidates = std::vector<uint32_t>(amount);
+
+  real *first = points + static_cast<size_t>((*dist)(*mt)) * dimension;
+  auto candidates = std::vector<real>(first, first + dimension);
+
+  double total = update(points, point_distances.data(),
+                        point_candidates.data(), amount, candidates.data(), 0,
+                        1, dimension);
+
+  uint32_t candidate_amount = 1;
+  double factor = static_cast<double>(oversampling) * clusters;
+
+  for (uint32_t round = 0;
+       round < rounds || (candidate_amount < clusters && total > 0); round++) {
+    sample(points, point_distances.data(), amount, dimension, factor, total,
+           mt, &candidates);
+
+    uint32_t first_candidate = candidate_amount;
+    candidate_amount = static_cast<uint32_t>(candidates.size() / dimension);
+
+    total = update(points, point_distances.data(), point_candidates.data(),
+                   amount, candidates.data(), first_candidate,
+                   candidate_amount, dimension);
+  }
+
+  auto weights = std::vector<uint32_t>(candidate_amount);
+  weigh(point_candidates.data(), amount, weights.data());
+
+  reduce(candidates.data(), weights.data(), candidate_amount, centroids,
+         clusters, dimension, mt);
+}
+
+}
+}
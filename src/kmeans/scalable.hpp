@@ -0,0 +1,68 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace kmeans {
+namespace scalable {
+
+// Scalable k-means++ (k-means||) oversamples candidate centroids in a few
+// rounds over the points and reduces the candidates to the final centroids
+// with a weighted k-means++. The building blocks below work on any subset of
+// the points so they can be combined with collectives to seed distributed
+// points.
+
+// Amount of sampling rounds and expected amount of candidates sampled per
+// round for each cluster.
+const uint32_t rounds = 5;
+const uint32_t oversampling = 2;
+
+// Lowers point_distances (amount) to the squared distance of each point to its
+// nearest candidate in [first_candidate, candidate_amount) and stores the index
+// of that candidate in point_candidates. Returns the sum of point_distances.
+double update(real *points,
+              double *point_distances,
+              uint32_t *point_candidates,
+              uint32_t amount,
+              real *candidates,
+              uint32_t first_candidate,
+              uint32_t candidate_amount,
+              uint32_t dimension);
+
+// Appends every point to candidates with probability factor * distance / total
+// where distance is its squared distance to its nearest candidate.
+void sample(real *points,
+            double *point_distances,
+            uint32_t amount,
+            uint32_t dimension,
+            double factor,
+            double total,
+            std::mt19937 *mt,
+            std::vector<real> *candidates);
+
+// Adds the amount of points nearest to each candidate to weights.
+void weigh(uint32_t *point_candidates, uint32_t amount, uint32_t *weights);
+
+// Picks clusters centroids from the weighted candidates with k-means++.
+void reduce(real *candidates,
+            uint32_t *weights,
+            uint32_t candidate_amount,
+            real *centroids,
+            uint16_t clusters,
+            uint32_t dimension,
+            std::mt19937 *mt);
+
+// k-means|| seeding of amount points that are all available locally.
+void centroids(real *points,
+               real *centroids,
+               uint32_t amount,
+               uint16_t clusters,
+               uint32_t dimension,
+               std::uniform_int_distribution<uint32_t> *dist,
+               std::mt19937 *mt);
+
+}
+}
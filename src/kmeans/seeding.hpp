@@ -0,0 +1,14 @@
+#pragma once
+
+namespace kmeans {
+
+// The algorithm used to pick the initial centroids of each repetition. Random
+// picks k distinct points uniformly at random while kmeanspp (k-means++) picks
+// each next centroid with a probability proportional to the squared distance
+// of a point to its nearest centroid picked so far. Scalable (k-means||)
+// oversamples candidates in a few rounds and reduces them to k centroids.
+// Given starts every repetition from centroids loaded from a file, e.g. the
+// centroids of a previous run on similar points.
+enum class seeding { random, kmeanspp, scalable, given };
+
+}
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <kmeans/accumulation.hpp>
+#include <kmeans/assignment.hpp>
+#include <kmeans/csr.hpp>
+#include <kmeans/kernel.hpp>
+#include <kmeans/real.hpp>
+#include <kmeans/seeding.hpp>
+
+#include <limits>
 #include <random>
+#include <string>
 
 namespace kmeans {
 
 struct data {
-  double *points;
+  real *points;
   uint16_t *point_clusters;
   uint16_t *lowest_cost_point_clusters;
-  double *centroids;
+  real *lowest_cost_centroids;
+  double lowest_cost = std::numeric_limits<double>::max();
+  real *centroids;
+  real *previous_centroids;
+  double *centroid_sums;
   uint32_t *centroid_point_indices;
   uint32_t *cluster_sizes;
 
@@ -19,7 +32,71 @@ struct data {
   std::uniform_int_distribution<uint32_t> *dist;
   std::mt19937 *mt;
 
-  data(double *points, uint32_t amount, uint16_t clusters, uint32_t dimension);
+  const kmeans::assignment assignment;
+  const uint32_t bounds;
+  const kmeans::kernel kernel;
+  const kmeans::seeding seeding;
+  const uint32_t batch_size;
+  const uint32_t batch_iterations;
+  const bool batch_refine;
+
+  // Out-of-core mode (see disk.hpp) goes over the points in windows of window
+  // points. Otherwise the window covers every point.
+  const bool out_of_core;
+  const uint32_t window;
+
+  // Sparse points (see csr.hpp) take the place of points, which is null.
+  const bool sparse;
+  const csr::matrix sparse_points;
+
+  // group() already sums the points of every cluster while it assigns them
+  // when fused (see accumulation.hpp), so centroids() doesn't read them again.
+  const bool fused;
+
+  // Period of the incremental iterations (see accumulation::incremental()), 0
+  // unless the sums are fused.
+  const uint32_t incremental;
+  accumulation::buffer buffer;
+
+  // Only allocated when the assignment algorithm keeps bounds.
+  double *upper_bounds = nullptr;
+  double *lower_bounds = nullptr;
+  double *centroid_drifts = nullptr;
+  double *centroid_distances = nullptr;
+  double *centroid_bounds = nullptr;
+  uint16_t *centroid_groups = nullptr;
+  uint16_t *group_centroids = nullptr;
+  uint32_t *group_offsets = nullptr;
+  double *group_drifts = nullptr;
+
+  // Only allocated for the gemm kernel (and the centroid norms for sparse
+  // points).
+  double *point_norms = nullptr;
+  double *centroid_norms = nullptr;
+  real *packed_centroids = nullptr;
+
+  // Only loaded when seeding from given centroids.
+  real *initial_centroids = nullptr;
+
+  // Only allocated for mini-batch k-means.
+  uint32_t *batch_points = nullptr;
+  uint16_t *batch_clusters = nullptr;
+  double *batch_centroids = nullptr;
+  uint32_t *batch_cluster_sizes = nullptr;
+
+  data(real *points,
+       const csr::matrix &sparse_points,
+       uint32_t amount,
+       uint16_t clusters,
+       uint32_t dimension,
+       kmeans::assignment assignment,
+       kmeans::kernel kernel,
+       kmeans::seeding seeding,
+       uint32_t batch_size,
+       uint32_t batch_iterations,
+       bool batch_refine,
+       uint32_t incremental,
+       const std::string &out_of_core_directory);
 
   ~data();
 };
@@ -1,23 +1,64 @@
 #include <kmeans/seq/kmeans.hpp>
 
+#include <kmeans/accumulation.hpp>
+#include <kmeans/csr.hpp>
+#include <kmeans/disk.hpp>
 #include <kmeans/distance.hpp>
+#include <kmeans/elkan.hpp>
+#include <kmeans/gemm.hpp>
+#include <kmeans/hamerly.hpp>
+#include <kmeans/lloyd.hpp>
+#include <kmeans/minibatch.hpp>
 #include <kmeans/random.hpp>
+#include <kmeans/scalable.hpp>
+#include <kmeans/yinyang.hpp>
 #include <kmeans/seq/data.hpp>
 
 #include <algorithm>
 
 namespace kmeans {
 
+// Returns the end of the window of points that starts at first and prepares
+// its points in out-of-core mode.
+static uint32_t window(data *data, uint32_t first)
+{
+  if (data->out_of_core) {
+    disk::advance(data->points, first, data->window, data->amount,
+                  data->dimension);
+  }
+
+  return first + std::min(data->window, data->amount - first);
+}
+
 static double cost(data *data)
 {
   double cost = 0;
 
-  for (uint32_t i = 0; i < data->amount; i++) {
-    double *point = data->points + i * data->dimension;
-    double *centroid = data->centroids +
+  if (data->sparse) {
+    gemm::norms(data->centroids, data->centroid_norms, data->clusters,
+                data->dimension);
+
+    for (uint32_t i = 0; i < data->amount; i++) {
+      uint16_t cluster = data->point_clusters[i];
+      real *centroid = data->centroids + cluster * data->dimension;
+
+      cost += csr::distance(data->sparse_points, i, centroid,
+                            data->centroid_norms[cluster]);
+    }
+
+    return cost;
+  }
+
+  for (uint32_t first = 0; first < data->amount; first += data->window) {
+    uint32_t last = window(data, first);
+
+    for (uint32_t i = first; i < last; i++) {
+      real *point = data->points + static_cast<size_t>(i) * data->dimension;
+      real *centroid = data->centroids +
                        data->point_clusters[i] * data->dimension;
 
-    cost += distance(point, centroid, data->dimension);
+      cost += distance(point, centroid, data->dimension);
+    }
   }
 
   return cost;
@@ -25,97 +66,298 @@ static double cost(data *data)
 
 static void centroids(data *data)
 {
-  std::fill_n(data->centroids, data->clusters * data->dimension, 0);
-  std::fill_n(data->cluster_sizes, data->clusters, 0);
+  std::copy_n(data->centroids, data->clusters * data->dimension,
+              data->previous_centroids);
 
-  for (uint32_t i = 0; i < data->amount; i++) {
-    uint16_t cluster = data->point_clusters[i];
-    data->cluster_sizes[cluster]++;
+  // Unless group() already summed the points (see data::fused).
+  if (!data->fused) {
+    for (uint32_t first = 0; first < data->amount; first += data->window) {
+      uint32_t last = window(data, first);
 
-    double *point = data->points + i * data->dimension;
-    double *centroid = data->centroids + cluster * data->dimension;
+      for (uint32_t i = first; i < last; i++) {
+        uint16_t cluster = data->point_clusters[i];
+        data->cluster_sizes[cluster]++;
 
-    for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] += point[j];
+        double *centroid_sum = data->centroid_sums + cluster * data->dimension;
+
+        if (data->sparse) {
+          csr::accumulate(centroid_sum, data->sparse_points, i);
+          continue;
+        }
+
+        real *point = data->points + static_cast<size_t>(i) * data->dimension;
+        accumulate(centroid_sum, point, data->dimension);
+      }
     }
   }
 
   for (uint16_t i = 0; i < data->clusters; i++) {
-    double *centroid = data->centroids + i * data->dimension;
+    real *centroid = data->centroids + i * data->dimension;
+    double *centroid_sum = data->centroid_sums + i * data->dimension;
+
+    // An empty cluster keeps its centroid instead of dividing by zero.
+    if (data->cluster_sizes[i] == 0) {
+      continue;
+    }
 
     for (uint32_t j = 0; j < data->dimension; j++) {
-      centroid[j] /= data->cluster_sizes[i];
+      centroid[j] = static_cast<real>(centroid_sum[j] /
+                                      data->cluster_sizes[i]);
     }
   }
+
+  if (data->assignment != assignment::lloyd) {
+    drift(data->previous_centroids, data->centroids, data->centroid_drifts,
+          data->clusters, data->dimension);
+  }
 }
 
-static bool group(data *data)
+// Moved only updates the sums of the previous iteration with the points that
+// changed cluster (see accumulation::incremental()).
+static bool group(data *data, bool moved)
 {
-  bool point_clusters_equal = true;
+  if (!moved) {
+    std::fill_n(data->centroid_sums, data->clusters * data->dimension, 0);
+    std::fill_n(data->cluster_sizes, data->clusters, 0);
+  }
 
-  for (uint32_t i = 0; i < data->amount; i++) {
-    uint16_t previous_cluster = data->point_clusters[i];
-    uint16_t cluster = previous_cluster;
+  accumulation::part part = {data->centroid_sums, data->cluster_sizes, moved};
 
-    double *point = data->points + i * data->dimension;
-    double *centroid = data->centroids + cluster * data->dimension;
+  if (data->sparse) {
+    gemm::norms(data->centroids, data->centroid_norms, data->clusters,
+                data->dimension);
 
-    double lowest_distance = kmeans::distance(point, centroid, data->dimension);
+    bool point_clusters_equal = true;
 
-    for (uint16_t j = 0; j < previous_cluster; j++) {
-      centroid = data->centroids + j * data->dimension;
+    for (uint32_t i = 0; i < data->amount; i++) {
+      uint16_t previous_cluster = data->point_clusters[i];
+      uint16_t cluster = csr::nearest(data->sparse_points, i, previous_cluster,
+                                      data->centroids, data->centroid_norms,
+                                      data->clusters, data->dimension);
 
-      double distance = kmeans::distance(point, centroid, data->dimension);
+      point_clusters_equal = point_clusters_equal &&
+                             previous_cluster == cluster;
+      data->point_clusters[i] = cluster;
 
-      if (distance < lowest_distance) {
-        cluster = j;
-        lowest_distance = distance;
+      if (data->fused) {
+        accumulation::add(part, previous_cluster, cluster,
+                          data->sparse_points, i, data->dimension);
       }
     }
 
-    for (uint16_t j = static_cast<uint16_t>(previous_cluster + 1);
-         j < data->clusters; j++) {
-      centroid = data->centroids + j * data->dimension;
+    return point_clusters_equal;
+  }
+
+  if (data->kernel == kernel::gemm) {
+    gemm::centroids(data->centroids, data->centroid_norms,
+                    data->packed_centroids, data->clusters, data->dimension);
+
+    bool point_clusters_equal = true;
+
+    for (uint32_t first = 0; first < data->amount; first += data->window) {
+      uint32_t last = window(data, first);
+
+      real *points = data->points + static_cast<size_t>(first) *
+                                        data->dimension;
+      uint16_t *point_clusters = data->point_clusters + first;
+
+      point_clusters_equal =
+          (data->fused
+               ? gemm::assign(points, data->point_norms + first,
+                              point_clusters, last - first,
+                              data->packed_centroids, data->centroid_norms,
+                              data->clusters, data->dimension, &data->buffer,
+                              data->centroid_sums, data->cluster_sizes, moved)
+               : gemm::assign(points, data->point_norms + first,
+                              point_clusters, last - first,
+                              data->packed_centroids, data->centroid_norms,
+                              data->clusters, data->dimension)) &&
+          point_clusters_equal;
+    }
+
+    return point_clusters_equal;
+  }
+
+  if (data->assignment == assignment::elkan) {
+    elkan::centroids(data->centroids, data->centroid_distances,
+                     data->centroid_bounds, data->clusters, data->dimension);
+  }
+
+  hamerly::drift drift = {};
 
-      double distance = kmeans::distance(point, centroid, data->dimension);
+  if (data->assignment == assignment::hamerly) {
+    hamerly::centroids(data->centroids, data->centroid_bounds, data->clusters,
+                       data->dimension);
+    drift = hamerly::drifts(data->centroid_drifts, data->clusters);
+  }
+
+  if (data->assignment == assignment::yinyang) {
+    yinyang::drifts(data->centroid_drifts, data->centroid_groups,
+                    data->group_drifts, data->clusters, data->bounds);
+  }
+
+  bool point_clusters_equal = true;
 
-      if (distance < lowest_distance) {
-        cluster = j;
-        lowest_distance = distance;
+  for (uint32_t first = 0; first < data->amount; first += data->window) {
+    uint32_t last = window(data, first);
+
+    for (uint32_t i = first; i < last; i++) {
+      uint16_t previous_cluster = data->point_clusters[i];
+      uint16_t cluster = previous_cluster;
+
+      real *point = data->points + static_cast<size_t>(i) * data->dimension;
+      double *lower_bounds = data->lower_bounds +
+                             static_cast<size_t>(i) * data->bounds;
+
+      switch (data->assignment) {
+        case assignment::lloyd:
+          cluster = lloyd::nearest(point, cluster, data->centroids,
+                                   data->clusters, data->dimension);
+          break;
+        case assignment::elkan:
+          cluster = elkan::nearest(point, cluster, data->centroids,
+                                   data->centroid_distances,
+                                   data->centroid_bounds, data->centroid_drifts,
+                                   data->upper_bounds + i, lower_bounds,
+                                   data->clusters, data->dimension);
+          break;
+        case assignment::hamerly:
+          cluster = hamerly::nearest(point, cluster, data->centroids,
+                                     data->centroid_bounds,
+                                     data->centroid_drifts, drift,
+                                     data->upper_bounds + i, lower_bounds,
+                                     data->clusters, data->dimension);
+          break;
+        case assignment::yinyang:
+          cluster = yinyang::nearest(
+              point, cluster, data->centroids, data->centroid_groups,
+              data->group_centroids, data->group_offsets,
+              data->centroid_drifts, data->group_drifts,
+              data->upper_bounds + i, lower_bounds, data->bounds,
+              data->dimension);
+          break;
       }
-    }
 
-    point_clusters_equal = point_clusters_equal && previous_cluster == cluster;
-    data->point_clusters[i] = cluster;
+      point_clusters_equal = point_clusters_equal &&
+                             previous_cluster == cluster;
+      data->point_clusters[i] = cluster;
+
+      if (data->fused) {
+        accumulation::add(part, previous_cluster, cluster, point,
+                          data->dimension);
+      }
+    }
   }
 
   return point_clusters_equal;
 }
 
+static void seed(data *data)
+{
+  switch (data->seeding) {
+    case seeding::random:
+      if (data->sparse) {
+        csr::centroids(data->sparse_points, data->centroids,
+                       data->centroid_point_indices, data->clusters,
+                       data->dimension, data->dist, data->mt);
+        break;
+      }
+
+      random::centroids(data->points, data->centroids,
+                        data->centroid_point_indices, data->clusters,
+                        data->dimension, data->dist, data->mt);
+      break;
+    case seeding::kmeanspp:
+      if (data->sparse) {
+        csr::kmeanspp(data->sparse_points, data->centroids,
+                      data->centroid_point_indices, data->amount,
+                      data->clusters, data->dimension, data->dist, data->mt);
+        break;
+      }
+
+      random::kmeanspp(data->points, data->centroids,
+                       data->centroid_point_indices, data->amount,
+                       data->clusters, data->dimension, data->dist, data->mt);
+      break;
+    case seeding::scalable:
+      scalable::centroids(data->points, data->centroids, data->amount,
+                          data->clusters, data->dimension, data->dist,
+                          data->mt);
+      break;
+    case seeding::given:
+      std::copy_n(data->initial_centroids, data->clusters * data->dimension,
+                  data->centroids);
+      break;
+  }
+}
+
+static void batches(data *data)
+{
+  std::fill_n(data->cluster_sizes, data->clusters, 0);
+
+  for (uint32_t i = 0; i < data->batch_iterations; i++) {
+    minibatch::sample(data->batch_points, data->batch_size, data->dist,
+                      data->mt);
+    minibatch::assign(data->points, data->batch_points, data->batch_clusters,
+                      data->batch_size, data->centroids, data->clusters,
+                      data->dimension);
+    minibatch::accumulate(data->points, data->batch_points,
+                          data->batch_clusters, data->batch_size,
+                          data->batch_centroids, data->batch_cluster_sizes,
+                          data->clusters, data->dimension);
+    minibatch::update(data->centroids, data->cluster_sizes,
+                      data->batch_centroids, data->batch_cluster_sizes,
+                      data->clusters, data->dimension);
+  }
+}
+
 static void run(data *data)
 {
-  random::centroids(data->points, data->centroids, data->centroid_point_indices,
-                    data->clusters, data->dimension, data->dist, data->mt);
+  seed(data);
+
+  if (data->batch_size > 0) {
+    batches(data);
+  }
 
   std::fill_n(data->point_clusters, data->amount, 0);
 
-  while (!group(data)) {
+  if (data->assignment != assignment::lloyd) {
+    reset(data->upper_bounds, data->lower_bounds, data->amount, data->bounds);
+    std::fill_n(data->centroid_drifts, data->clusters, 0);
+  }
+
+  if (data->assignment == assignment::yinyang) {
+    yinyang::partition(data->centroids, data->centroid_groups,
+                       data->group_centroids, data->group_offsets,
+                       data->clusters, data->bounds, data->dimension);
+  }
+
+  // Mini-batch k-means only needs a single pass over every point to assign
+  // each point to its nearest centroid unless asked to refine the centroids.
+  if (data->batch_size > 0 && !data->batch_refine) {
+    group(data, false);
+    return;
+  }
+
+  for (uint32_t iteration = 0;
+       !group(data, accumulation::incremental(data->incremental, iteration));
+       iteration++) {
     centroids(data);
   }
 }
 
 void run(data *data, uint32_t repetitions)
 {
-  double lowest_cost = std::numeric_limits<double>::max();
-
   for (uint32_t i = 0; i < repetitions; i++) {
     run(data);
 
     double cost = kmeans::cost(data);
-    if (cost < lowest_cost) {
-      lowest_cost = cost;
+    if (cost < data->lowest_cost) {
+      data->lowest_cost = cost;
       std::copy_n(data->point_clusters, data->amount,
                   data->lowest_cost_point_clusters);
+      std::copy_n(data->centroids, data->clusters * data->dimension,
+                  data->lowest_cost_centroids);
     }
   }
 }
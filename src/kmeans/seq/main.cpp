@@ -1,29 +1,36 @@
 #include <kmeans/args.hpp>
+#include <kmeans/CSVReader.hpp>
+#include <kmeans/disk.hpp>
 #include <kmeans/io.hpp>
 #include <kmeans/seq/data.hpp>
 #include <kmeans/seq/kmeans.hpp>
 
-#include <algorithm>
 #include <chrono>
 #include <iostream>
 
 static kmeans::data initialize(const kmeans::args &args)
 {
-  std::vector<std::vector<double>> points2D = kmeans::io::input(
-      args.input_csv_path);
-
-  uint32_t amount = static_cast<uint32_t>(points2D.size());
-  uint32_t dimension = static_cast<uint32_t>(points2D[0].size());
-  double *points = new double[amount * dimension]();
+  if (!args.out_of_core_directory.empty()) {
+    kmeans::disk::check(args.input_csv_path);
+  }
 
-  for (uint32_t i = 0; i < amount; i++) {
-    double *point = points + i * dimension;
-    double *point2D = &points2D[i].front();
+  uint32_t amount;
+  uint32_t dimension;
+  kmeans::real *points = nullptr;
+  kmeans::csr::matrix sparse_points;
 
-    std::copy_n(point2D, dimension, point);
+  if (args.sparse) {
+    sparse_points = kmeans::CSVReader(args.input_csv_path)
+                        .read_sparse(&amount, &dimension);
+  } else {
+    points = kmeans::io::input(args.input_csv_path, &amount, &dimension);
   }
 
-  return kmeans::data(points, amount, args.clusters, dimension);
+  return kmeans::data(points, sparse_points, amount, args.clusters, dimension,
+                      args.assignment, args.kernel, args.seeding,
+                      args.batch_size, args.batch_iterations,
+                      args.batch_refine, args.incremental,
+                      args.out_of_core_directory);
 }
 
 int main(int argc, char *argv[])
@@ -31,6 +38,11 @@ int main(int argc, char *argv[])
   kmeans::args args = kmeans::args::parse(argc, argv);
   kmeans::data data = initialize(args);
 
+  if (args.seeding == kmeans::seeding::given) {
+    data.initial_centroids = kmeans::io::centroids(
+        args.initial_centroids_path, data.clusters, data.dimension);
+  }
+
   auto start = std::chrono::system_clock::now();
 
   kmeans::run(&data, args.repetitions);
@@ -41,7 +53,13 @@ int main(int argc, char *argv[])
   std::cout << duration.count() << std::endl;
 
   kmeans::io::output(data.lowest_cost_point_clusters, data.amount,
-                     args.output_csv_path);
+                     args.output_csv_path, args.binary_output);
+
+  if (!args.centroids_path.empty()) {
+    kmeans::io::output_centroids(data.lowest_cost_centroids, data.clusters,
+                                 data.dimension, data.lowest_cost,
+                                 args.centroids_path);
+  }
 
   return 0;
 }
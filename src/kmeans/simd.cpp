@@ -0,0 +1,124 @@
+#include <kmeans/simd.hpp>
+
+#include <cstdlib>
+#include <string>
+
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace kmeans {
+namespace simd {
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+{
+#ifdef _MSC_VER
+  int values[4];
+  __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+
+  for (int i = 0; i < 4; i++) {
+    registers[i] = static_cast<uint32_t>(values[i]);
+  }
+#else
+  __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2],
+                registers[3]);
+#endif
+}
+
+// Register state the operating system saves on a context switch.
+static uint64_t xgetbv()
+{
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return static_cast<uint64_t>(edx) << 32 | eax;
+#endif
+}
+
+static level supported()
+{
+  uint32_t registers[4] = {};
+
+  cpuid(0, 0, registers);
+  uint32_t leaves = registers[0];
+
+  if (leaves < 7) {
+    return level::sse;
+  }
+
+  cpuid(1, 0, registers);
+  bool osxsave = (registers[2] >> 27 & 1) != 0;
+  bool fma = (registers[2] >> 12 & 1) != 0;
+
+  if (!osxsave) {
+    return level::sse;
+  }
+
+  uint64_t state = xgetbv();
+
+  cpuid(7, 0, registers);
+  bool avx2 = (registers[1] >> 5 & 1) != 0;
+  bool avx512f = (registers[1] >> 16 & 1) != 0;
+
+  // XMM, YMM, opmask and both halves of the ZMM registers.
+  if (avx512f && (state & 0xE6) == 0xE6) {
+    return level::avx512;
+  }
+
+  // XMM and YMM registers.
+  if (avx2 && fma && (state & 0x6) == 0x6) {
+    return level::avx2;
+  }
+
+  return level::sse;
+}
+
+level detect()
+{
+  level level = supported();
+
+  const char *requested = std::getenv("KMEANS_SIMD");
+
+  if (requested == nullptr) {
+    return level;
+  }
+
+  std::string name = requested;
+
+  if (name == "sse") {
+    return level::sse;
+  }
+
+  if (name == "avx2" && level == level::avx512) {
+    return level::avx2;
+  }
+
+  return level;
+}
+
+const kernels &selected()
+{
+  static const kernels &kernels = []() -> const simd::kernels & {
+    switch (detect()) {
+      case level::avx512:
+        return avx512;
+      case level::avx2:
+        return avx2;
+      case level::sse:
+        break;
+    }
+
+    return sse;
+  }();
+
+  return kernels;
+}
+
+}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+
+namespace kmeans {
+namespace simd {
+
+// Instruction set levels we have kernels for. SSE2 is part of x86-64 so the
+// sse kernels run everywhere.
+enum class level { sse, avx2, avx512 };
+
+// The vectorized kernels of a single instruction set level. Each level is
+// compiled in its own translation unit with the matching compiler flags.
+struct kernels {
+  // Squared distance between point and centroid.
+  double (*distance)(real *point, real *centroid, uint32_t dimension);
+
+  // Adds point to the double precision sum of a centroid.
+  void (*accumulate)(double *sum, real *point, uint32_t dimension);
+
+  // Stores the dot products of gemm::tile points with a packed panel of
+  // gemm::panel centroids in dots (gemm::tile * gemm::panel).
+  void (*tile)(real **tile_points,
+               real *panel_centroids,
+               double *dots,
+               uint32_t dimension);
+};
+
+extern const kernels sse;
+extern const kernels avx2;
+extern const kernels avx512;
+
+// Highest level supported by both the processor (CPUID) and the operating
+// system (XGETBV). The KMEANS_SIMD environment variable (sse, avx2 or avx512)
+// lowers the level, which is useful to compare the kernels on one machine.
+level detect();
+
+// Kernels of the detected level. The level is detected on the first call.
+const kernels &selected();
+
+}
+}
@@ -0,0 +1,216 @@
+#include <kmeans/simd.hpp>
+
+#include <kmeans/gemm.hpp>
+
+#include <immintrin.h>
+
+namespace kmeans {
+namespace simd {
+
+// Short vectors don't amortize the horizontal sum of the vector kernel.
+static const uint32_t scalar_dimension = 8;
+
+static double scalar(real *point, real *centroid, uint32_t dimension)
+{
+  double total_distance = 0;
+
+  for (uint32_t i = 0; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+#ifdef KMEANS_FLOAT
+
+static double distance(real *point, real *centroid, uint32_t dimension)
+{
+  if (dimension < scalar_dimension) {
+    return scalar(point, centroid, dimension);
+  }
+
+  __m256 first = _mm256_setzero_ps();
+  __m256 second = _mm256_setzero_ps();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= dimension; i += 16) {
+    __m256 a = _mm256_sub_ps(_mm256_loadu_ps(point + i),
+                             _mm256_loadu_ps(centroid + i));
+    __m256 b = _mm256_sub_ps(_mm256_loadu_ps(point + i + 8),
+                             _mm256_loadu_ps(centroid + i + 8));
+
+    first = _mm256_fmadd_ps(a, a, first);
+    second = _mm256_fmadd_ps(b, b, second);
+  }
+
+  if (i + 8 <= dimension) {
+    __m256 a = _mm256_sub_ps(_mm256_loadu_ps(point + i),
+                             _mm256_loadu_ps(centroid + i));
+
+    first = _mm256_fmadd_ps(a, a, first);
+    i += 8;
+  }
+
+  first = _mm256_add_ps(first, second);
+
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(first),
+                           _mm256_extractf128_ps(first, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+
+  double total_distance = _mm_cvtss_f32(half);
+
+  for (; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+static void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  uint32_t i = 0;
+
+  for (; i + 4 <= dimension; i += 4) {
+    _mm256_storeu_pd(sum + i,
+                     _mm256_add_pd(_mm256_loadu_pd(sum + i),
+                                   _mm256_cvtps_pd(_mm_loadu_ps(point + i))));
+  }
+
+  for (; i < dimension; i++) {
+    sum[i] += point[i];
+  }
+}
+
+// A panel of floats fills a single YMM register.
+static void tile(real **tile_points,
+                 real *panel_centroids,
+                 double *dots,
+                 uint32_t dimension)
+{
+  __m256 accumulators[gemm::tile];
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    accumulators[a] = _mm256_setzero_ps();
+  }
+
+  for (uint32_t k = 0; k < dimension; k++) {
+    __m256 centroids = _mm256_loadu_ps(panel_centroids + k * gemm::panel);
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      __m256 x = _mm256_broadcast_ss(tile_points[a] + k);
+      accumulators[a] = _mm256_fmadd_ps(x, centroids, accumulators[a]);
+    }
+  }
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    __m128 low = _mm256_castps256_ps128(accumulators[a]);
+    __m128 high = _mm256_extractf128_ps(accumulators[a], 1);
+
+    _mm256_storeu_pd(dots + a * gemm::panel, _mm256_cvtps_pd(low));
+    _mm256_storeu_pd(dots + a * gemm::panel + 4, _mm256_cvtps_pd(high));
+  }
+}
+
+#else
+
+static double distance(real *point, real *centroid, uint32_t dimension)
+{
+  if (dimension < scalar_dimension) {
+    return scalar(point, centroid, dimension);
+  }
+
+  __m256d first = _mm256_setzero_pd();
+  __m256d second = _mm256_setzero_pd();
+
+  uint32_t i = 0;
+
+  for (; i + 8 <= dimension; i += 8) {
+    __m256d a = _mm256_sub_pd(_mm256_loadu_pd(point + i),
+                              _mm256_loadu_pd(centroid + i));
+    __m256d b = _mm256_sub_pd(_mm256_loadu_pd(point + i + 4),
+                              _mm256_loadu_pd(centroid + i + 4));
+
+    first = _mm256_fmadd_pd(a, a, first);
+    second = _mm256_fmadd_pd(b, b, second);
+  }
+
+  if (i + 4 <= dimension) {
+    __m256d a = _mm256_sub_pd(_mm256_loadu_pd(point + i),
+                              _mm256_loadu_pd(centroid + i));
+
+    first = _mm256_fmadd_pd(a, a, first);
+    i += 4;
+  }
+
+  first = _mm256_add_pd(first, second);
+
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(first),
+                            _mm256_extractf128_pd(first, 1));
+  half = _mm_add_sd(half, _mm_unpackhi_pd(half, half));
+
+  double total_distance = _mm_cvtsd_f64(half);
+
+  for (; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+static void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  uint32_t i = 0;
+
+  for (; i + 4 <= dimension; i += 4) {
+    _mm256_storeu_pd(sum + i, _mm256_add_pd(_mm256_loadu_pd(sum + i),
+                                            _mm256_loadu_pd(point + i)));
+  }
+
+  for (; i < dimension; i++) {
+    sum[i] += point[i];
+  }
+}
+
+static void tile(real **tile_points,
+                 real *panel_centroids,
+                 double *dots,
+                 uint32_t dimension)
+{
+  __m256d accumulators[gemm::tile][2];
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    accumulators[a][0] = _mm256_setzero_pd();
+    accumulators[a][1] = _mm256_setzero_pd();
+  }
+
+  for (uint32_t k = 0; k < dimension; k++) {
+    real *centroids = panel_centroids + k * gemm::panel;
+
+    __m256d first = _mm256_loadu_pd(centroids);
+    __m256d second = _mm256_loadu_pd(centroids + 4);
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      __m256d x = _mm256_broadcast_sd(tile_points[a] + k);
+
+      accumulators[a][0] = _mm256_fmadd_pd(x, first, accumulators[a][0]);
+      accumulators[a][1] = _mm256_fmadd_pd(x, second, accumulators[a][1]);
+    }
+  }
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    _mm256_storeu_pd(dots + a * gemm::panel, accumulators[a][0]);
+    _mm256_storeu_pd(dots + a * gemm::panel + 4, accumulators[a][1]);
+  }
+}
+
+#endif
+
+const kernels avx2 = {distance, accumulate, tile};
+
+}
+}
@@ -0,0 +1,198 @@
+#include <kmeans/simd.hpp>
+
+#include <kmeans/gemm.hpp>
+
+#include <immintrin.h>
+
+namespace kmeans {
+namespace simd {
+
+// Mask of the first amount (< 8) lanes, used for the remainder of a loop.
+static __mmask8 remainder(uint32_t amount)
+{
+  return static_cast<__mmask8>((1u << amount) - 1);
+}
+
+#ifdef KMEANS_FLOAT
+
+// Mask of the first amount (< 16) float lanes.
+static __mmask16 remainder16(uint32_t amount)
+{
+  return static_cast<__mmask16>((1u << amount) - 1);
+}
+
+#endif
+
+// Short vectors don't amortize the horizontal sum of the vector kernel.
+static const uint32_t scalar_dimension = 8;
+
+static double scalar(real *point, real *centroid, uint32_t dimension)
+{
+  double total_distance = 0;
+
+  for (uint32_t i = 0; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+#ifdef KMEANS_FLOAT
+
+static double distance(real *point, real *centroid, uint32_t dimension)
+{
+  if (dimension < scalar_dimension) {
+    return scalar(point, centroid, dimension);
+  }
+
+  __m512 first = _mm512_setzero_ps();
+  __m512 second = _mm512_setzero_ps();
+
+  uint32_t i = 0;
+
+  for (; i + 32 <= dimension; i += 32) {
+    __m512 a = _mm512_sub_ps(_mm512_loadu_ps(point + i),
+                             _mm512_loadu_ps(centroid + i));
+    __m512 b = _mm512_sub_ps(_mm512_loadu_ps(point + i + 16),
+                             _mm512_loadu_ps(centroid + i + 16));
+
+    first = _mm512_fmadd_ps(a, a, first);
+    second = _mm512_fmadd_ps(b, b, second);
+  }
+
+  for (; i < dimension; i += 16) {
+    __mmask16 mask = dimension - i >= 16 ? static_cast<__mmask16>(0xFFFF)
+                                         : remainder16(dimension - i);
+    __m512 a = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, point + i),
+                             _mm512_maskz_loadu_ps(mask, centroid + i));
+
+    first = _mm512_fmadd_ps(a, a, first);
+  }
+
+  return _mm512_reduce_add_ps(_mm512_add_ps(first, second));
+}
+
+static void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  for (uint32_t i = 0; i < dimension; i += 8) {
+    __mmask8 mask = dimension - i >= 8 ? static_cast<__mmask8>(0xFF)
+                                       : remainder(dimension - i);
+
+    __m512 values = _mm512_maskz_loadu_ps(mask, point + i);
+    __m512d sums = _mm512_add_pd(
+        _mm512_maskz_loadu_pd(mask, sum + i),
+        _mm512_cvtps_pd(_mm512_castps512_ps256(values)));
+
+    _mm512_mask_storeu_pd(sum + i, mask, sums);
+  }
+}
+
+// A panel of floats only fills half a ZMM register so the tile uses the
+// 256-bit FMA instructions every AVX-512 processor has.
+static void tile(real **tile_points,
+                 real *panel_centroids,
+                 double *dots,
+                 uint32_t dimension)
+{
+  __m256 accumulators[gemm::tile];
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    accumulators[a] = _mm256_setzero_ps();
+  }
+
+  for (uint32_t k = 0; k < dimension; k++) {
+    __m256 centroids = _mm256_loadu_ps(panel_centroids + k * gemm::panel);
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      __m256 x = _mm256_broadcast_ss(tile_points[a] + k);
+      accumulators[a] = _mm256_fmadd_ps(x, centroids, accumulators[a]);
+    }
+  }
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    _mm512_storeu_pd(dots + a * gemm::panel, _mm512_cvtps_pd(accumulators[a]));
+  }
+}
+
+#else
+
+static double distance(real *point, real *centroid, uint32_t dimension)
+{
+  if (dimension < scalar_dimension) {
+    return scalar(point, centroid, dimension);
+  }
+
+  __m512d first = _mm512_setzero_pd();
+  __m512d second = _mm512_setzero_pd();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= dimension; i += 16) {
+    __m512d a = _mm512_sub_pd(_mm512_loadu_pd(point + i),
+                              _mm512_loadu_pd(centroid + i));
+    __m512d b = _mm512_sub_pd(_mm512_loadu_pd(point + i + 8),
+                              _mm512_loadu_pd(centroid + i + 8));
+
+    first = _mm512_fmadd_pd(a, a, first);
+    second = _mm512_fmadd_pd(b, b, second);
+  }
+
+  for (; i < dimension; i += 8) {
+    __mmask8 mask = dimension - i >= 8 ? static_cast<__mmask8>(0xFF)
+                                       : remainder(dimension - i);
+
+    __m512d a = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, point + i),
+                              _mm512_maskz_loadu_pd(mask, centroid + i));
+
+    first = _mm512_fmadd_pd(a, a, first);
+  }
+
+  return _mm512_reduce_add_pd(_mm512_add_pd(first, second));
+}
+
+static void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  for (uint32_t i = 0; i < dimension; i += 8) {
+    __mmask8 mask = dimension - i >= 8 ? static_cast<__mmask8>(0xFF)
+                                       : remainder(dimension - i);
+
+    __m512d sums = _mm512_add_pd(_mm512_maskz_loadu_pd(mask, sum + i),
+                                 _mm512_maskz_loadu_pd(mask, point + i));
+
+    _mm512_mask_storeu_pd(sum + i, mask, sums);
+  }
+}
+
+static void tile(real **tile_points,
+                 real *panel_centroids,
+                 double *dots,
+                 uint32_t dimension)
+{
+  __m512d accumulators[gemm::tile];
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    accumulators[a] = _mm512_setzero_pd();
+  }
+
+  for (uint32_t k = 0; k < dimension; k++) {
+    __m512d centroids = _mm512_loadu_pd(panel_centroids + k * gemm::panel);
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      __m512d x = _mm512_set1_pd(tile_points[a][k]);
+
+      accumulators[a] = _mm512_fmadd_pd(x, centroids, accumulators[a]);
+    }
+  }
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    _mm512_storeu_pd(dots + a * gemm::panel, accumulators[a]);
+  }
+}
+
+#endif
+
+const kernels avx512 = {distance, accumulate, tile};
+
+}
+}
@@ -0,0 +1,212 @@
+#include <kmeans/simd.hpp>
+
+#include <kmeans/gemm.hpp>
+
+#include <emmintrin.h>
+
+namespace kmeans {
+namespace simd {
+
+// Short vectors don't amortize the horizontal sum of the vector kernel.
+static const uint32_t scalar_dimension = 8;
+
+static double scalar(real *point, real *centroid, uint32_t dimension)
+{
+  double total_distance = 0;
+
+  for (uint32_t i = 0; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+#ifdef KMEANS_FLOAT
+
+static double distance(real *point, real *centroid, uint32_t dimension)
+{
+  if (dimension < scalar_dimension) {
+    return scalar(point, centroid, dimension);
+  }
+
+  __m128 first = _mm_setzero_ps();
+  __m128 second = _mm_setzero_ps();
+
+  uint32_t i = 0;
+
+  for (; i + 8 <= dimension; i += 8) {
+    __m128 a = _mm_sub_ps(_mm_loadu_ps(point + i), _mm_loadu_ps(centroid + i));
+    __m128 b = _mm_sub_ps(_mm_loadu_ps(point + i + 4),
+                          _mm_loadu_ps(centroid + i + 4));
+
+    first = _mm_add_ps(first, _mm_mul_ps(a, a));
+    second = _mm_add_ps(second, _mm_mul_ps(b, b));
+  }
+
+  first = _mm_add_ps(first, second);
+  first = _mm_add_ps(first, _mm_movehl_ps(first, first));
+  first = _mm_add_ss(first, _mm_shuffle_ps(first, first, 1));
+
+  double total_distance = _mm_cvtss_f32(first);
+
+  for (; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+static void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  uint32_t i = 0;
+
+  for (; i + 4 <= dimension; i += 4) {
+    __m128 values = _mm_loadu_ps(point + i);
+
+    _mm_storeu_pd(sum + i, _mm_add_pd(_mm_loadu_pd(sum + i),
+                                      _mm_cvtps_pd(values)));
+    _mm_storeu_pd(sum + i + 2,
+                  _mm_add_pd(_mm_loadu_pd(sum + i + 2),
+                             _mm_cvtps_pd(_mm_movehl_ps(values, values))));
+  }
+
+  for (; i < dimension; i++) {
+    sum[i] += point[i];
+  }
+}
+
+// A 4x8 tile of floats fits in 8 of the 16 XMM registers.
+static void tile(real **tile_points,
+                 real *panel_centroids,
+                 double *dots,
+                 uint32_t dimension)
+{
+  __m128 accumulators[gemm::tile][2];
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    accumulators[a][0] = _mm_setzero_ps();
+    accumulators[a][1] = _mm_setzero_ps();
+  }
+
+  for (uint32_t k = 0; k < dimension; k++) {
+    real *centroids = panel_centroids + k * gemm::panel;
+
+    __m128 first = _mm_loadu_ps(centroids);
+    __m128 second = _mm_loadu_ps(centroids + 4);
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      __m128 x = _mm_set1_ps(tile_points[a][k]);
+
+      accumulators[a][0] = _mm_add_ps(accumulators[a][0],
+                                      _mm_mul_ps(x, first));
+      accumulators[a][1] = _mm_add_ps(accumulators[a][1],
+                                      _mm_mul_ps(x, second));
+    }
+  }
+
+  for (uint32_t a = 0; a < gemm::tile; a++) {
+    for (uint32_t b = 0; b < 2; b++) {
+      __m128 values = accumulators[a][b];
+      double *row = dots + a * gemm::panel + b * 4;
+
+      _mm_storeu_pd(row, _mm_cvtps_pd(values));
+      _mm_storeu_pd(row + 2, _mm_cvtps_pd(_mm_movehl_ps(values, values)));
+    }
+  }
+}
+
+#else
+
+static double distance(real *point, real *centroid, uint32_t dimension)
+{
+  if (dimension < scalar_dimension) {
+    return scalar(point, centroid, dimension);
+  }
+
+  __m128d first = _mm_setzero_pd();
+  __m128d second = _mm_setzero_pd();
+
+  uint32_t i = 0;
+
+  for (; i + 4 <= dimension; i += 4) {
+    __m128d a = _mm_sub_pd(_mm_loadu_pd(point + i), _mm_loadu_pd(centroid + i));
+    __m128d b = _mm_sub_pd(_mm_loadu_pd(point + i + 2),
+                           _mm_loadu_pd(centroid + i + 2));
+
+    first = _mm_add_pd(first, _mm_mul_pd(a, a));
+    second = _mm_add_pd(second, _mm_mul_pd(b, b));
+  }
+
+  first = _mm_add_pd(first, second);
+  first = _mm_add_sd(first, _mm_unpackhi_pd(first, first));
+
+  double total_distance = _mm_cvtsd_f64(first);
+
+  for (; i < dimension; i++) {
+    double distance = point[i] - centroid[i];
+    total_distance += distance * distance;
+  }
+
+  return total_distance;
+}
+
+static void accumulate(double *sum, real *point, uint32_t dimension)
+{
+  uint32_t i = 0;
+
+  for (; i + 2 <= dimension; i += 2) {
+    _mm_storeu_pd(sum + i, _mm_add_pd(_mm_loadu_pd(sum + i),
+                                      _mm_loadu_pd(point + i)));
+  }
+
+  for (; i < dimension; i++) {
+    sum[i] += point[i];
+  }
+}
+
+// With 16 XMM registers a full 4x8 tile doesn't fit, so the panel is handled
+// as two halves of 4 centroids each.
+static void tile(real **tile_points,
+                 real *panel_centroids,
+                 double *dots,
+                 uint32_t dimension)
+{
+  for (uint32_t half = 0; half < gemm::panel; half += 4) {
+    __m128d accumulators[gemm::tile][2];
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      accumulators[a][0] = _mm_setzero_pd();
+      accumulators[a][1] = _mm_setzero_pd();
+    }
+
+    for (uint32_t k = 0; k < dimension; k++) {
+      real *centroids = panel_centroids + k * gemm::panel + half;
+
+      __m128d first = _mm_loadu_pd(centroids);
+      __m128d second = _mm_loadu_pd(centroids + 2);
+
+      for (uint32_t a = 0; a < gemm::tile; a++) {
+        __m128d x = _mm_set1_pd(tile_points[a][k]);
+
+        accumulators[a][0] = _mm_add_pd(accumulators[a][0],
+                                        _mm_mul_pd(x, first));
+        accumulators[a][1] = _mm_add_pd(accumulators[a][1],
+                                        _mm_mul_pd(x, second));
+      }
+    }
+
+    for (uint32_t a = 0; a < gemm::tile; a++) {
+      _mm_storeu_pd(dots + a * gemm::panel + half, accumulators[a][0]);
+      _mm_storeu_pd(dots + a * gemm::panel + half + 2, accumulators[a][1]);
+    }
+  }
+}
+
+#endif
+
+const kernels sse = {distance, accumulate, tile};
+
+}
+}
@@ -0,0 +1,193 @@
+#include <kmeans/yinyang.hpp>
+
+#include <kmeans/distance.hpp>
+#include <kmeans/lloyd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace kmeans {
+namespace yinyang {
+
+static const uint32_t group_size = 10;
+static const uint32_t partition_iterations = 5;
+
+uint32_t groups(uint16_t clusters)
+{
+  return std::max<uint32_t>(clusters / group_size, 1);
+}
+
+void partition(real *centroids,
+               uint16_t *centroid_groups,
+               uint16_t *group_centroids,
+               uint32_t *group_offsets,
+               uint16_t clusters,
+               uint32_t groups,
+               uint32_t dimension)
+{
+  auto group_means = std::vector<real>(groups * dimension);
+  auto group_sizes = std::vector<uint32_t>(groups);
+
+  // The centroids are random points so evenly spaced centroids make for
+  // reasonably spread out initial groups.
+  for (uint32_t i = 0; i < groups; i++) {
+    real *centroid = centroids + (i * clusters / groups) * dimension;
+    std::copy_n(centroid, dimension, &group_means[i * dimension]);
+  }
+
+  std::fill_n(centroid_groups, clusters, 0);
+
+  for (uint32_t iteration = 0; iteration < partition_iterations; iteration++) {
+    for (uint16_t i = 0; i < clusters; i++) {
+      real *centroid = centroids + i * dimension;
+      centroid_groups[i] = lloyd::nearest(centroid, centroid_groups[i],
+                                          group_means.data(),
+                                          static_cast<uint16_t>(groups),
+                                          dimension);
+    }
+
+    std::fill(group_means.begin(), group_means.end(), 0);
+    std::fill(group_sizes.begin(), group_sizes.end(), 0);
+
+    for (uint16_t i = 0; i < clusters; i++) {
+      uint16_t group = centroid_groups[i];
+      group_sizes[group]++;
+
+      real *centroid = centroids + i * dimension;
+      real *group_mean = &group_means[group * dimension];
+
+      for (uint32_t j = 0; j < dimension; j++) {
+        group_mean[j] += centroid[j];
+      }
+    }
+
+    for (uint32_t i = 0; i < groups; i++) {
+      real *group_mean = &group_means[i * dimension];
+
+      // An empty group keeps a mean of zero which only makes it less likely
+      // to receive centroids in the next iteration.
+      for (uint32_t j = 0; j < dimension && group_sizes[i] > 0; j++) {
+        group_mean[j] /= static_cast<real>(group_sizes[i]);
+      }
+    }
+  }
+
+  std::fill_n(group_offsets, groups + 1, 0);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    group_offsets[centroid_groups[i] + 1]++;
+  }
+
+  for (uint32_t i = 0; i < groups; i++) {
+    group_offsets[i + 1] += group_offsets[i];
+  }
+
+  auto group_ends = std::vector<uint32_t>(group_offsets,
+                                          group_offsets + groups);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    group_centroids[group_ends[centroid_groups[i]]++] = i;
+  }
+}
+
+void drifts(double *centroid_drifts,
+            uint16_t *centroid_groups,
+            double *group_drifts,
+            uint16_t clusters,
+            uint32_t groups)
+{
+  std::fill_n(group_drifts, groups, 0);
+
+  for (uint16_t i = 0; i < clusters; i++) {
+    double &group_drift = group_drifts[centroid_groups[i]];
+    group_drift = std::max(group_drift, centroid_drifts[i]);
+  }
+}
+
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 uint16_t *centroid_groups,
+                 uint16_t *group_centroids,
+                 uint32_t *group_offsets,
+                 double *centroid_drifts,
+                 double *group_drifts,
+                 double *upper_bound,
+                 double *lower_bounds,
+                 uint32_t groups,
+                 uint32_t dimension)
+{
+  double upper = *upper_bound + centroid_drifts[cluster];
+  double lowest_bound = std::numeric_limits<double>::max();
+
+  for (uint32_t g = 0; g < groups; g++) {
+    lower_bounds[g] -= group_drifts[g];
+    lowest_bound = std::min(lowest_bound, lower_bounds[g]);
+  }
+
+  if (upper <= lowest_bound) {
+    *upper_bound = upper;
+    return cluster;
+  }
+
+  real *centroid = centroids + cluster * dimension;
+  upper = std::sqrt(kmeans::distance(point, centroid, dimension));
+
+  for (uint32_t g = 0; g < groups; g++) {
+    if (lower_bounds[g] >= upper) {
+      continue;
+    }
+
+    uint16_t group_cluster = cluster;
+    double first = std::numeric_limits<double>::max();
+    double second = std::numeric_limits<double>::max();
+
+    for (uint32_t m = group_offsets[g]; m < group_offsets[g + 1]; m++) {
+      uint16_t j = group_centroids[m];
+
+      if (j == cluster) {
+        continue;
+      }
+
+      centroid = centroids + j * dimension;
+      double distance = std::sqrt(kmeans::distance(point, centroid,
+                                                   dimension));
+
+      if (distance < first) {
+        second = first;
+        first = distance;
+        group_cluster = j;
+      } else if (distance < second) {
+        second = distance;
+      }
+    }
+
+    if (first < upper) {
+      // The previous centroid is no longer the nearest so its distance now
+      // bounds the centroids of its group.
+      uint16_t previous_group = centroid_groups[cluster];
+
+      if (previous_group == g) {
+        second = std::min(second, upper);
+      } else {
+        lower_bounds[previous_group] = std::min(lower_bounds[previous_group],
+                                                upper);
+      }
+
+      lower_bounds[g] = second;
+      cluster = group_cluster;
+      upper = first;
+    } else {
+      lower_bounds[g] = first;
+    }
+  }
+
+  *upper_bound = upper;
+
+  return cluster;
+}
+
+}
+}
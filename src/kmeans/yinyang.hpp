@@ -0,0 +1,53 @@
+#pragma once
+
+#include <kmeans/real.hpp>
+
+#include <cstdint>
+
+namespace kmeans {
+namespace yinyang {
+
+// Amount of groups the centroids are divided in.
+uint32_t groups(uint16_t clusters);
+
+// Divides the centroids in groups by clustering the centroids themselves with
+// a few iterations of Lloyd. Stores the group of each centroid in
+// centroid_groups (clusters), the centroids ordered by group in
+// group_centroids (clusters) and where each group starts in group_centroids in
+// group_offsets (groups + 1).
+void partition(real *centroids,
+               uint16_t *centroid_groups,
+               uint16_t *group_centroids,
+               uint32_t *group_offsets,
+               uint16_t clusters,
+               uint32_t groups,
+               uint32_t dimension);
+
+// Stores the largest drift of the centroids of each group in group_drifts
+// (groups).
+void drifts(double *centroid_drifts,
+            uint16_t *centroid_groups,
+            double *group_drifts,
+            uint16_t clusters,
+            uint32_t groups);
+
+// Returns the nearest centroid of point using Yinyang's group filtering.
+// upper_bound points to the upper bound on the distance of point to its
+// current centroid and lower_bounds to the lower bounds on its distance to the
+// centroids of each group (excluding its current centroid). Groups whose lower
+// bound exceeds the upper bound are skipped without computing any distance.
+uint16_t nearest(real *point,
+                 uint16_t cluster,
+                 real *centroids,
+                 uint16_t *centroid_groups,
+                 uint16_t *group_centroids,
+                 uint32_t *group_offsets,
+                 double *centroid_drifts,
+                 double *group_drifts,
+                 double *upper_bound,
+                 double *lower_bounds,
+                 uint32_t groups,
+                 uint32_t dimension);
+
+}
+}
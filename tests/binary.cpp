@@ -0,0 +1,83 @@
+// Validates headers of binary point files whose sizes overflow 64 bits when
+// they're computed naively, which made the readers go past the end of the
+// mapping.
+
+#include <kmeans/binary.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const std::string path = "test-binary.bin";
+
+// Writes a file with the given header that is followed by amount values.
+static void write(const kmeans::binary::header &header, uint64_t amount)
+{
+  std::ofstream file(path, std::ios::binary);
+  auto padding = std::vector<char>(header.offset - sizeof(header) +
+                                   amount * kmeans::binary::size(header.dtype));
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+}
+
+// Whether inspect() accepts the file.
+static bool accepted()
+{
+  try {
+    kmeans::binary::inspect(path);
+    return true;
+  } catch (const std::runtime_error &) {
+    return false;
+  }
+}
+
+int main()
+{
+  int failures = 0;
+
+  auto check = [&failures](const char *name, bool expected) {
+    if (accepted() != expected) {
+      std::printf("The header with %s is %s\n", name,
+                  expected ? "rejected" : "accepted");
+      failures++;
+    }
+  };
+
+  kmeans::binary::header header =
+      kmeans::binary::describe(2, 1, kmeans::binary::dtype::float64);
+
+  write(header, 2);
+  check("two points", true);
+
+  write(header, 1);
+  check("a missing point", false);
+
+  // stride * 8 wraps around to 0, so the second point seems to start at the
+  // offset.
+  header.stride = uint64_t(1) << 61;
+  write(header, 2);
+  check("a stride of 2^61 values", false);
+
+  // (amount - 1) * stride wraps around to 0.
+  header.amount = (uint64_t(1) << 32) - 1;
+  header.stride = (uint64_t(1) << 32) + 1;
+  write(header, 2);
+  check("a product of amount and stride of 2^64", false);
+
+  header = kmeans::binary::describe(1, 1, kmeans::binary::dtype::float64);
+  header.offset = UINT64_MAX - 7;
+  write(kmeans::binary::describe(1, 1, kmeans::binary::dtype::float64), 1);
+
+  std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.close();
+  check("an offset past the end", false);
+
+  std::remove(path.c_str());
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+// Indexes points past 2^32 values, which wraps around when the offset of a
+// point is computed in 32 bits. The points are an anonymous mapping that is
+// only backed where it's written, so the test doesn't need the memory.
+
+#include <kmeans/minibatch.hpp>
+
+#include <cstdint>
+#include <cstdio>
+
+#include <sys/mman.h>
+
+int main()
+{
+  const uint32_t dimension = 16;
+  const uint32_t last = (uint32_t(1) << 28);
+  const size_t size = (static_cast<size_t>(last) + 1) * dimension *
+                      sizeof(kmeans::real);
+
+  void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (address == MAP_FAILED) {
+    std::puts("Skipped: can't reserve the address space");
+    return 0;
+  }
+
+  auto points = static_cast<kmeans::real *>(address);
+  kmeans::real *last_point = points + static_cast<size_t>(last) * dimension;
+
+  for (uint32_t j = 0; j < dimension; j++) {
+    points[j] = 1;
+    last_point[j] = 2;
+  }
+
+  uint32_t batch_points[] = {last};
+  uint16_t batch_clusters[] = {0};
+  double batch_centroids[dimension] = {};
+  uint32_t batch_cluster_sizes[] = {0};
+
+  kmeans::minibatch::accumulate(points, batch_points, batch_clusters, 1,
+                                batch_centroids, batch_cluster_sizes, 1,
+                                dimension);
+
+  int failures = 0;
+
+  for (uint32_t j = 0; j < dimension; j++) {
+    if (batch_centroids[j] != 2) {
+      std::printf("Value %u of the last point is %f instead of 2\n", j,
+                  batch_centroids[j]);
+      failures++;
+    }
+  }
+
+  munmap(address, size);
+
+  return failures == 0 ? 0 : 1;
+}
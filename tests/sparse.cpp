@@ -0,0 +1,56 @@
+// Reads sparse points with an all-zero point in the middle, which is stored as
+// an empty line and has to stay a point so the later labels don't shift.
+
+#include <kmeans/CSVReader.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static const std::string path = "test-sparse.svm";
+
+int main()
+{
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "0:1 2:3\n"
+            "\n"
+            "# comment\n"
+            "\r\n"
+            "1:2\n";
+  }
+
+  uint32_t amount;
+  uint32_t dimension;
+  kmeans::csr::matrix points = kmeans::CSVReader(path).read_sparse(&amount,
+                                                                   &dimension);
+
+  int failures = 0;
+  const uint64_t offsets[] = {0, 2, 2, 2, 3};
+
+  if (amount != 4 || dimension != 3) {
+    std::printf("Read %u points of dimension %u instead of 4 of dimension 3\n",
+                amount, dimension);
+    failures++;
+  } else {
+    for (uint32_t i = 0; i <= amount; i++) {
+      if (points.offsets[i] != offsets[i]) {
+        std::printf("Offset %u is %llu instead of %llu\n", i,
+                    static_cast<unsigned long long>(points.offsets[i]),
+                    static_cast<unsigned long long>(offsets[i]));
+        failures++;
+      }
+    }
+
+    if (points.indices[2] != 1 || points.values[2] != 2) {
+      std::puts("The last point isn't 1:2");
+      failures++;
+    }
+  }
+
+  kmeans::csr::release(points);
+  std::remove(path.c_str());
+
+  return failures == 0 ? 0 : 1;
+}